@@ -0,0 +1,11 @@
+#version 450 core
+
+layout(location = 0) in vec3 aPos;
+
+layout(location = 0) uniform mat4 viewProj;
+layout(location = 1) uniform vec3 boxMin;
+layout(location = 2) uniform vec3 boxMax;
+
+void main() {
+    gl_Position = viewProj * vec4(mix(boxMin, boxMax, aPos), 1.0);
+}
@@ -0,0 +1,79 @@
+#version 450 core
+
+// attributeless, vertices of a level grid come from gl_VertexID
+
+// same outputs as shader.vert
+layout(location = 0) out vec3 position;
+layout(location = 1) out vec2 texCoord;
+layout(location = 2) out vec2 heightGradient;
+layout(location = 3) out float ambientOcclusion; // only baked into the chunk vertices
+layout(location = 4) out vec4 splat;
+
+layout(binding = 3) uniform sampler2DArray clipmap;
+
+#include "frame_block.glsl"
+
+layout(location = 7) uniform ivec2 levelOrigin; // in samples of the level
+layout(location = 8) uniform int level;
+layout(location = 9) uniform int levelCount;
+
+// sync with Clipmap
+const int gridSize = 256;
+const int textureSize = gridSize + 1;
+
+#include "materials.glsl"
+
+// sync with terrain.comp
+const float normalScale = 256.0;
+
+float fetchHeight(ivec2 sampleIdx) {
+    // toroidal addressing, % is undefined for negative operands
+    const ivec2 texel = sampleIdx - textureSize * ivec2(floor(vec2(sampleIdx) / float(textureSize)));
+    return texelFetch(clipmap, ivec3(texel, level), 0).r;
+}
+
+float renderHeight(float height) {
+    return pow(height, heightPower) * heightScale;
+}
+
+void main() {
+    const ivec2 gridPos = ivec2(gl_VertexID % (gridSize + 1), gl_VertexID / (gridSize + 1));
+    const ivec2 sampleIdx = levelOrigin + gridPos;
+    float height = fetchHeight(sampleIdx);
+    float y = renderHeight(height);
+
+    // odd vertices on the outer edge lie halfway between two vertices of the next coarser level. moving them onto the
+    // coarser edge closes the t-junction cracks between levels
+    if (level < levelCount - 1) {
+        const bool onVerticalEdge = gridPos.x == 0 || gridPos.x == gridSize;
+        const bool onHorizontalEdge = gridPos.y == 0 || gridPos.y == gridSize;
+        ivec2 step = ivec2(0);
+        if (onVerticalEdge && (gridPos.y & 1) == 1) {
+            step = ivec2(0, 1);
+        } else if (onHorizontalEdge && (gridPos.x & 1) == 1) {
+            step = ivec2(1, 0);
+        }
+
+        if (step != ivec2(0)) {
+            const float a = fetchHeight(sampleIdx - step);
+            const float b = fetchHeight(sampleIdx + step);
+            height = 0.5 * (a + b);
+            y = 0.5 * (renderHeight(a) + renderHeight(b));
+        }
+    }
+
+    const vec2 xz = vec2(sampleIdx * (1 << level));
+    gl_Position = viewProj * vec4(xz.x, y, xz.y, 1.0);
+    position = vec3(xz.x, height, xz.y);
+    texCoord = xz;
+    ambientOcclusion = 1.0;
+
+    // central differences, one sided on the edges where the neighbours are outside the level
+    const ivec2 lo = max(sampleIdx - 1, levelOrigin);
+    const ivec2 hi = min(sampleIdx + 1, levelOrigin + gridSize);
+    const vec2 diff = vec2(fetchHeight(ivec2(hi.x, sampleIdx.y)) - fetchHeight(ivec2(lo.x, sampleIdx.y)),
+        fetchHeight(ivec2(sampleIdx.x, hi.y)) - fetchHeight(ivec2(sampleIdx.x, lo.y)));
+    heightGradient = diff / (vec2(hi - lo) * float(1 << level));
+    // generated without the detail noise, so there is no variation
+    splat = splatWeights(height, length(heightGradient) * normalScale, 0.0);
+}
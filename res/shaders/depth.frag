@@ -0,0 +1,5 @@
+#version 450 core
+
+// depth only, used for the depth prepass and occlusion queries
+void main() {
+}
@@ -0,0 +1,204 @@
+#version 450 core
+
+// Far chunks ray marched per pixel instead of rasterized. Every chunk has a pyramid of maximum heights on top of its
+// height map, the ray skips over whole nodes of it and only tests the cells it gets close to. Writes depth, so it
+// composites with the rasterized chunks and the skybox.
+
+layout(location = 0) in vec2 ndc;
+
+layout(location = 0) out vec4 FragColor;
+
+layout(binding = 2) uniform sampler2DArray heightMap;
+layout(binding = 4) uniform sampler2DArray maxHeights; // level l - 1 holds the nodes of level l
+layout(binding = 7) uniform sampler2DArray splatMap;   // same layout as the height map
+
+#include "materials.glsl"
+
+#include "frame_block.glsl"
+
+layout(location = 2) uniform mat4 invViewProj;
+layout(location = 7) uniform float sampleSpacing;
+
+// xy origin, z horizontal distance to the camera, w layer. sorted front to back. sync with FarField
+const int maxChunks = 64;
+layout(location = 8) uniform int farChunkCount;
+layout(location = 9) uniform vec4 farChunks[maxChunks];
+
+const int chunkSize = 1024;
+const int topLevel = 10; // log2(chunkSize), a single node covers the chunk
+const int maxSteps = 512;
+const float noHit = 1e30;
+
+uint layer;
+
+float renderedHeight(float height) {
+    return pow(height, heightPower) * heightScale;
+}
+
+float sampleHeight(ivec2 p) {
+    return texelFetch(heightMap, ivec3(p, layer), 0).r;
+}
+
+// level 0 nodes are single cells
+float nodeMaxHeight(ivec2 node, int level) {
+    if (level == 0) {
+        return max(max(sampleHeight(node), sampleHeight(node + ivec2(1, 0))),
+            max(sampleHeight(node + ivec2(0, 1)), sampleHeight(node + ivec2(1, 1))));
+    }
+    return texelFetch(maxHeights, ivec3(node, layer), level - 1).r;
+}
+
+ivec2 cellAt(vec2 p) {
+    return clamp(ivec2(floor(p)), ivec2(0), ivec2(chunkSize - 2));
+}
+
+// bilinear between the corners of the cell, close enough to the two triangles of the mesh
+float surfaceHeight(vec2 p, bool rendered) {
+    const ivec2 cell = cellAt(p);
+    const vec2 f = clamp(p - vec2(cell), 0.0, 1.0);
+    vec4 h = vec4(sampleHeight(cell), sampleHeight(cell + ivec2(1, 0)), sampleHeight(cell + ivec2(0, 1)),
+        sampleHeight(cell + ivec2(1, 1)));
+    if (rendered) {
+        h = pow(h, vec4(heightPower)) * heightScale;
+    }
+    return mix(mix(h.x, h.y, f.x), mix(h.z, h.w, f.x), f.y);
+}
+
+// derivatives of the bilinear surface per sample, before the rendering transform
+vec2 surfaceGradient(vec2 p) {
+    const ivec2 cell = cellAt(p);
+    const vec2 f = clamp(p - vec2(cell), 0.0, 1.0);
+    const vec4 h = vec4(sampleHeight(cell), sampleHeight(cell + ivec2(1, 0)), sampleHeight(cell + ivec2(0, 1)),
+        sampleHeight(cell + ivec2(1, 1)));
+    return vec2(mix(h.y - h.x, h.w - h.z, f.y), mix(h.z - h.x, h.w - h.y, f.x));
+}
+
+// the ray is in samples of the chunk horizontally and in world units vertically
+bool marchChunk(vec3 origin, vec3 dir, float tStart, float tEnd, out float tHit) {
+    float t = tStart;
+    int level = topLevel;
+    for (int i = 0; i < maxSteps && t < tEnd; i++) {
+        const vec3 p = origin + dir * t;
+        const ivec2 node = cellAt(p.xz) >> level;
+        const vec2 nodeMin = vec2(node << level);
+        const vec2 nodeMax = nodeMin + float(1 << level);
+        const vec2 tSides = (mix(nodeMin, nodeMax, greaterThan(dir.xz, vec2(0.0))) - origin.xz) / dir.xz;
+        const float tExit = min(min(tSides.x, tSides.y), tEnd);
+        const float yExit = origin.y + dir.y * tExit;
+
+        // passes over the node, continue with the next one and try to skip more at once
+        if (min(p.y, yExit) > renderedHeight(nodeMaxHeight(node, level))) {
+            t = tExit + 1e-3;
+            level = min(level + 1, topLevel);
+            continue;
+        }
+
+        if (level > 0) {
+            level--;
+            continue;
+        }
+
+        const float above = p.y - surfaceHeight(p.xz, true);
+        const float aboveExit = yExit - surfaceHeight(origin.xz + dir.xz * tExit, true);
+        if (above <= 0.0) {
+            tHit = t;
+            return true;
+        }
+        if (aboveExit <= 0.0) {
+            tHit = mix(t, tExit, above / (above - aboveExit));
+            return true;
+        }
+
+        t = tExit + 1e-3;
+        level = min(level + 1, topLevel);
+    }
+    return false;
+}
+
+// same as shader.frag
+const vec3 sunDir = normalize(vec3(0.4, 0.8, 0.3));
+
+vec3 terrainNormal(vec3 position, vec2 heightGradient) {
+    const float slope = heightScale * heightPower * pow(max(position.y, 1e-4), heightPower - 1.0);
+    const vec2 gradient = heightGradient * slope;
+    return normalize(vec3(-gradient.x, 1.0, -gradient.y));
+}
+
+vec4 applyFog(in vec4 color, vec3 position) {
+    float maxDist = fogDistance.y;
+    float minDist = fogDistance.x;
+    vec4  fogColor = vec4(0.9, 0.8, 0.7, 1.0);
+
+    float dist = length(camPos - position);
+    float factor = (maxDist - dist) / (maxDist - minDist);
+    factor = clamp(factor, 0.0, 1.0);
+
+    return mix(fogColor, color, factor);
+}
+
+void main() {
+    const vec4 nearPoint = invViewProj * vec4(ndc, -1.0, 1.0);
+    const vec4 farPoint = invViewProj * vec4(ndc, 1.0, 1.0);
+    vec3 dir = normalize(farPoint.xyz / farPoint.w - nearPoint.xyz / nearPoint.w);
+    // keep the divisions by the direction finite
+    dir = mix(dir, vec3(1e-6), lessThan(abs(dir), vec3(1e-6)));
+
+    const float extent = (chunkSize - 1) * sampleSpacing;
+    const float minY = min(0.0, heightScale);
+    const float maxY = max(0.0, heightScale);
+    const vec3 localDir = vec3(dir.x / sampleSpacing, dir.y, dir.z / sampleSpacing);
+
+    float tHit = noHit;
+    uint hitLayer = 0;
+    vec2 hitOrigin = vec2(0.0);
+    for (int i = 0; i < farChunkCount; i++) {
+        // the ray reaches the remaining chunks only after the hit
+        if (farChunks[i].z > tHit) {
+            break;
+        }
+
+        const vec3 boxMin = vec3(farChunks[i].x, minY, farChunks[i].y);
+        const vec3 boxMax = vec3(farChunks[i].x + extent, maxY, farChunks[i].y + extent);
+        const vec3 t0 = (boxMin - camPos) / dir;
+        const vec3 t1 = (boxMax - camPos) / dir;
+        const vec3 tNear = min(t0, t1);
+        const vec3 tFar = max(t0, t1);
+        const float tEnter = max(max(max(tNear.x, tNear.y), tNear.z), 0.0);
+        const float tExit = min(min(min(tFar.x, tFar.y), tFar.z), tHit);
+        if (tEnter >= tExit) {
+            continue;
+        }
+
+        layer = uint(farChunks[i].w);
+        const vec3 localOrigin = vec3((camPos.x - farChunks[i].x) / sampleSpacing, camPos.y,
+            (camPos.z - farChunks[i].y) / sampleSpacing);
+        float t;
+        if (marchChunk(localOrigin, localDir, tEnter, tExit, t)) {
+            tHit = t;
+            hitLayer = layer;
+            hitOrigin = farChunks[i].xy;
+        }
+    }
+
+    // shade before discarding, the texture lookups need derivatives of the whole quad
+    layer = hitLayer;
+    const vec3 hit = camPos + dir * min(tHit, 1e5);
+    const vec2 hitSample = (hit.xz - hitOrigin) / sampleSpacing;
+    const vec3 position = vec3(hit.x, surfaceHeight(hitSample, false), hit.z);
+    const vec2 texCoord = hit.xz;
+    const vec2 heightGradient = surfaceGradient(hitSample) / sampleSpacing;
+
+    const vec4 splat = texture(splatMap, vec3((hitSample + 0.5) / float(chunkSize), hitLayer));
+
+    vec4 col = materialColor(texCoord, dFdx(texCoord), dFdy(texCoord), splat);
+    col *= position.y;
+    col.rgb *= 0.4 + 0.6 * max(dot(terrainNormal(position, heightGradient), sunDir), 0.0);
+    FragColor = applyFog(col, position);
+
+    if (tHit == noHit) {
+        discard;
+    }
+
+    const vec4 clipPos = viewProj * vec4(hit, 1.0);
+    gl_FragDepth = clipPos.z / clipPos.w * 0.5 + 0.5;
+}
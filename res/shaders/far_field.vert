@@ -0,0 +1,9 @@
+#version 450 core
+
+// attributeless fullscreen triangle
+layout(location = 0) out vec2 ndc;
+
+void main() {
+    ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
@@ -0,0 +1,10 @@
+// per frame data, sync with FrameData in frame_data.h. shaders #include this, Shader expands it
+layout(std140, binding = 0) uniform FrameBlock {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    vec3 camPos;
+    float heightScale;
+    vec2 fogDistance;
+    float heightPower;
+};
@@ -0,0 +1,55 @@
+#version 450 core
+
+// attributeless, one instance per coarse chunk of the horizon ring. vertices of its grid come from gl_VertexID
+
+// same outputs as shader.vert
+layout(location = 0) out vec3 position;
+layout(location = 1) out vec2 texCoord;
+layout(location = 2) out vec2 heightGradient;
+layout(location = 3) out float ambientOcclusion; // only baked into the chunk vertices
+layout(location = 4) out vec4 splat;
+
+layout(binding = 5) uniform sampler2DArray horizon;
+
+#include "frame_block.glsl"
+
+layout(location = 7) uniform ivec2 horizonCenter; // coarse chunk of the camera
+
+// sync with HorizonRing
+const int quadsPerSide = 64;
+const int chunkExtent = 4096;
+const int radius = 10;
+const int chunksPerSide = radius * 2 + 1;
+
+#include "materials.glsl"
+
+// sync with terrain.comp
+const float normalScale = 256.0;
+
+void main() {
+    const ivec2 chunk = horizonCenter + ivec2(gl_InstanceID % chunksPerSide, gl_InstanceID / chunksPerSide) - radius;
+    // toroidal addressing, % is undefined for negative operands
+    const ivec2 wrapped = chunk - chunksPerSide * ivec2(floor(vec2(chunk) / float(chunksPerSide)));
+    const int layer = wrapped.x + wrapped.y * chunksPerSide;
+
+    const ivec2 gridPos = ivec2(gl_VertexID % (quadsPerSide + 1), gl_VertexID / (quadsPerSide + 1));
+    const float height = texelFetch(horizon, ivec3(gridPos, layer), 0).r;
+
+    const vec2 xz = vec2(chunk * chunkExtent + gridPos * (chunkExtent / quadsPerSide));
+    gl_Position = viewProj * vec4(xz.x, pow(height, heightPower) * heightScale, xz.y, 1.0);
+    position = vec3(xz.x, height, xz.y);
+    texCoord = xz;
+    ambientOcclusion = 1.0;
+
+    // central differences, one sided on the edges of the chunk
+    const ivec2 lo = max(gridPos - 1, 0);
+    const ivec2 hi = min(gridPos + 1, quadsPerSide);
+    const float right = texelFetch(horizon, ivec3(hi.x, gridPos.y, layer), 0).r;
+    const float left = texelFetch(horizon, ivec3(lo.x, gridPos.y, layer), 0).r;
+    const float down = texelFetch(horizon, ivec3(gridPos.x, hi.y, layer), 0).r;
+    const float up = texelFetch(horizon, ivec3(gridPos.x, lo.y, layer), 0).r;
+    const vec2 diff = vec2(right - left, down - up);
+    heightGradient = diff / (vec2(hi - lo) * float(chunkExtent / quadsPerSide));
+    // generated without the detail noise, so there is no variation
+    splat = splatWeights(height, length(heightGradient) * normalScale, 0.0);
+}
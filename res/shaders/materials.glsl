@@ -0,0 +1,35 @@
+// material layers, sync with the materials in main.cpp: grass, rock, snow, dirt. shaders #include this, Shader expands
+// it. nothing in here needs derivatives, so any stage can use it
+layout(binding = 0) uniform sampler2DArray materials;
+const int materialCount = 4;
+const float materialScale[materialCount] = float[](1024.0, 512.0, 768.0, 640.0); // world units per repeat
+
+const float rockSlope = 0.6;  // steepness in normal space where rock takes over
+const float snowHeight = 0.8; // height map value above which snow settles on the flat parts
+
+// weights of the materials at a sample, they add up to 1. variation breaks up the edges between them and is 0 where
+// there is no detail noise
+vec4 splatWeights(float height, float slope, float variation) {
+    const float rock = smoothstep(rockSlope - 0.2, rockSlope + 0.2, slope + variation * 0.2);
+    float remaining = 1.0 - rock;
+    const float snow = remaining * smoothstep(snowHeight - 0.03, snowHeight + 0.03, height + variation * 0.05);
+    remaining -= snow;
+    const float dirt = remaining * smoothstep(0.2, 0.5, variation);
+    remaining -= dirt;
+    return vec4(remaining, rock, snow, dirt);
+}
+
+// only the materials with weight are sampled, so adding materials does not add work where they are absent. dx and dy
+// are the derivatives of the world position texCoord, taken by the caller in uniform control flow
+vec4 materialColor(vec2 texCoord, vec2 dx, vec2 dy, vec4 splat) {
+    const vec4 weights = splat / max(dot(splat, vec4(1.0)), 1e-3);
+
+    vec4 col = vec4(0.0);
+    for (int i = 0; i < materialCount; i++) {
+        if (weights[i] > 0.0) {
+            const float scale = materialScale[i];
+            col += weights[i] * textureGrad(materials, vec3(texCoord / scale, i), dx / scale, dy / scale);
+        }
+    }
+    return col;
+}
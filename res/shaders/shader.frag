@@ -2,14 +2,50 @@
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec2 heightGradient; // of the height map, per world unit
+layout(location = 3) in float ambientOcclusion;
+layout(location = 4) in vec4 splat; // material weights from terrain.comp
 
 layout(location = 0) out vec4 FragColor;
 
-layout(binding = 0) uniform sampler2D rockTexture;
-layout(binding = 1) uniform sampler2D grassTexture;
+#include "materials.glsl"
 
-layout(location = 5) uniform vec3 camPos;
-layout(location = 6) uniform vec2 fogDistance;
+layout(binding = 6) uniform sampler2DArrayShadow shadowMap;
+
+#include "frame_block.glsl"
+
+// sync with ShadowCascades, nearest cascade first
+const int cascadeCount = 3;
+layout(location = 20) uniform bool shadows;
+layout(location = 21) uniform mat4 lightViewProj[cascadeCount];
+
+#ifdef VIRTUAL_TEXTURE
+// the materials come baked from the virtual texture, a lookup costs the same for any number of them. the feedback writes
+// have to come from visible fragments only
+layout(early_fragment_tests) in;
+
+layout(location = 5) in vec2 chunkUv;
+layout(location = 6) flat in uint chunkSlot;
+
+// sync with VirtualTexture
+const int pageSize = 128;
+const int pageBorder = 4;
+const int pagesPerSide = 16;
+const int pageLevels = 5;
+const int feedbackScale = 8;
+
+layout(binding = 8) uniform usampler2DArray pageTable; // layer per slot, level per page level
+layout(binding = 9) uniform sampler2D pageCache;
+layout(binding = 0, r32ui) uniform writeonly uimage2D feedback;
+layout(location = 24) uniform ivec2 feedbackOffset; // the pixel of each feedbackScale^2 block that writes this frame
+#endif
+
+#ifdef HORIZON
+// the horizon ring is cut away where the streamed chunks are. sync with TerrainGen
+layout(location = 10) uniform ivec2 residentCenter;
+layout(location = 11) uniform int residentDistance;
+const float chunkPitch = 1023.0;
+#endif
 
 // Fog parameters, could make them uniforms and pass them into the fragment shader
 vec4 applyFog(in vec4 color) {
@@ -24,12 +60,70 @@ vec4 applyFog(in vec4 color) {
     return mix(fogColor, color, factor);
 }
 
+const vec3 sunDir = normalize(vec3(0.4, 0.8, 0.3));
+
+vec3 terrainNormal() {
+    // chain rule through pow(height, heightPower) * heightScale
+    const float slope = heightScale * heightPower * pow(max(position.y, 1e-4), heightPower - 1.0);
+    const vec2 gradient = heightGradient * slope;
+    return normalize(vec3(-gradient.x, 1.0, -gradient.y));
+}
+
+#ifdef VIRTUAL_TEXTURE
+vec4 virtualColor() {
+    const vec2 texel = chunkUv * float(pageSize * pagesPerSide);
+    const float footprint = max(length(dFdx(texel)), length(dFdy(texel)));
+    const int level = clamp(int(floor(log2(max(footprint, 1e-6)))), 0, pageLevels - 1);
+    const int side = pagesPerSide >> level;
+    const ivec2 page = min(ivec2(chunkUv * float(side)), side - 1);
+
+    // the page this fragment wants, not the one it gets
+    if (ivec2(gl_FragCoord.xy) % feedbackScale == feedbackOffset) {
+        const uint request = uint(page.x) | (uint(page.y) << 6) | (uint(level) << 12) | (chunkSlot << 16);
+        imageStore(feedback, ivec2(gl_FragCoord.xy) / feedbackScale, uvec4(request));
+    }
+
+    // the entry points at the page itself or at its closest resident ancestor
+    const uvec4 entry = texelFetch(pageTable, ivec3(page, chunkSlot), level);
+    const int mapped = int(entry.z);
+    const vec2 pageUv = chunkUv * float(pagesPerSide >> mapped) - vec2(page >> (mapped - level));
+    const vec2 cacheTexel = vec2(entry.xy) * float(pageSize + 2 * pageBorder) + float(pageBorder) + pageUv * float(pageSize);
+    return textureLod(pageCache, cacheTexel / vec2(textureSize(pageCache, 0)), 0.0);
+}
+#endif
+
+// the first cascade that contains the position decides
+float sunVisibility() {
+    if (!shadows) {
+        return 1.0;
+    }
+
+    const vec3 worldPos = vec3(position.x, pow(position.y, heightPower) * heightScale, position.z);
+    for (int i = 0; i < cascadeCount; i++) {
+        const vec4 lightPos = lightViewProj[i] * vec4(worldPos, 1.0);
+        const vec3 coord = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+        if (all(greaterThan(coord.xy, vec2(0.01))) && all(lessThan(coord.xy, vec2(0.99)))) {
+            return texture(shadowMap, vec4(coord.xy, i, coord.z));
+        }
+    }
+    return 1.0;
+}
+
 void main() {
-    vec4 grassCol = texture(grassTexture, texCoord / 1024);
-    vec4 rockCol = texture(rockTexture, texCoord / 512);
-    vec4 col = mix(grassCol, rockCol, 1 - position.y);
+#ifdef HORIZON
+    const ivec2 chunkOffset = abs(ivec2(floor((position.xz - vec2(residentCenter)) / chunkPitch)) - residentCenter);
+    if (chunkOffset.x + chunkOffset.y <= residentDistance) {
+        discard;
+    }
+#endif
 
+#ifdef VIRTUAL_TEXTURE
+    vec4 col = virtualColor();
+#else
+    vec4 col = materialColor(texCoord, dFdx(texCoord), dFdy(texCoord), splat);
+#endif
     col *= position.y;
+    col.rgb *= 0.4 * ambientOcclusion + 0.6 * max(dot(terrainNormal(), sunDir), 0.0) * sunVisibility();
     col = applyFog(col);
 
     FragColor = col;
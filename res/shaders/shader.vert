@@ -1,23 +1,79 @@
 #version 450 core
 
 layout(location = 0) in vec3 aPos;
+layout(location = 1) in uint aNormal; // octahedral normal and ambient occlusion
 
 layout(location = 0) out vec3 position;
 layout(location = 1) out vec2 texCoord;
+layout(location = 2) out vec2 heightGradient; // of the height map, per world unit
+layout(location = 3) out float ambientOcclusion;
+layout(location = 4) out vec4 splat; // material weights
+layout(location = 5) out vec2 chunkUv; // position in the chunk, for the virtual texture
+layout(location = 6) flat out uint chunkSlot;
+
+// the depth prepass uses this shader too, and the color pass depends on both producing the exact same depth
+invariant gl_Position;
 
 layout(location = 0) uniform mat4 model;
-layout(location = 1) uniform mat4 view;
-layout(location = 2) uniform mat4 proj;
 
-layout(location = 3) uniform float heightScale;
-layout(location = 4) uniform float heightPower;
+// one layer per buffer slot, sync with TerrainGen and VertexLayout in terrain_gen.h
+layout(binding = 7) uniform sampler2DArray splatMap;
+layout(location = 1) uniform uint vertexLayout;
+const uint layoutMorton = 1u;
+const uint chunkSize = 1024u;
+
+#include "frame_block.glsl"
+
+// sync with terrain.comp
+const float normalScale = 256.0;
+
+vec3 octDecode(vec2 oct) {
+    vec3 n = vec3(oct.x, 1.0 - abs(oct.x) - abs(oct.y), oct.y);
+    if (n.y < 0.0) {
+        n.xz = (1.0 - abs(n.zx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(n.xz, vec2(0.0)));
+    }
+    return normalize(n);
+}
+
+// gathers the even bits of x into the lower 16 bits
+uint compact1By1(uint x) {
+    x &= 0x55555555u;
+    x = (x | (x >> 1)) & 0x33333333u;
+    x = (x | (x >> 2)) & 0x0f0f0f0fu;
+    x = (x | (x >> 4)) & 0x00ff00ffu;
+    x = (x | (x >> 8)) & 0x0000ffffu;
+    return x;
+}
+
+// gl_VertexID includes the base vertex, so it is the index into the whole vertex buffer
+ivec3 splatTexel() {
+    const uint idx = uint(gl_VertexID);
+    const uint slot = idx / (chunkSize * chunkSize);
+    const uint local = idx % (chunkSize * chunkSize);
+    if (vertexLayout == layoutMorton) {
+        return ivec3(compact1By1(local), compact1By1(local >> 1), slot);
+    }
+    return ivec3(local % chunkSize, local / chunkSize, slot);
+}
 
 void main() {
     vec3 vertPos = aPos;
     vertPos.y = pow(vertPos.y, heightPower);
     vertPos.y *= heightScale;
 
-    gl_Position = proj * view * vec4(vertPos, 1.0);
+    gl_Position = viewProj * vec4(vertPos, 1.0);
     position = aPos;
     texCoord = aPos.xz;
+
+    const vec2 oct = vec2(aNormal & 0xfffu, (aNormal >> 12) & 0xfffu) / 4095.0 * 2.0 - 1.0;
+    const vec3 normal = octDecode(oct);
+    ambientOcclusion = float(aNormal >> 24) / 255.0;
+    heightGradient = -normal.xz / (max(normal.y, 1e-3) * normalScale);
+#ifndef DEPTH_ONLY
+    // the depth and shadow passes only need the position
+    const ivec3 splatPos = splatTexel();
+    splat = texelFetch(splatMap, splatPos, 0);
+    chunkUv = vec2(splatPos.xy) / float(chunkSize - 1u);
+    chunkSlot = uint(splatPos.z);
+#endif
 }
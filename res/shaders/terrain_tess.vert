@@ -0,0 +1,14 @@
+#version 450 core
+
+// attributeless, emits the corners of a grid of quad patches covering the chunk
+layout(location = 0) out vec2 uv;
+
+layout(location = 10) uniform uint patchesPerSide;
+
+const vec2 corners[4] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main() {
+    const uint patchIdx = gl_VertexID / 4;
+    const vec2 patchPos = vec2(patchIdx % patchesPerSide, patchIdx / patchesPerSide);
+    uv = (patchPos + corners[gl_VertexID % 4]) / float(patchesPerSide);
+}
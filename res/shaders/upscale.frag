@@ -0,0 +1,36 @@
+#version 450 core
+
+// bicubic resampling of the scene, rendered at a lower resolution, onto the window
+layout(location = 0) in vec2 ndc;
+
+layout(location = 0) out vec4 FragColor;
+
+layout(binding = 0) uniform sampler2D scene;
+layout(location = 0) uniform ivec2 renderSize; // used part of the scene texture, from its lower left corner
+
+// catmull-rom weights of the 4 texels around a position t of the way between the middle two
+vec4 cubicWeights(float t) {
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    return vec4(-0.5 * t3 + t2 - 0.5 * t, 1.5 * t3 - 2.5 * t2 + 1.0, -1.5 * t3 + 2.0 * t2 + 0.5 * t,
+        0.5 * t3 - 0.5 * t2);
+}
+
+void main() {
+    // in texels of the rendered part, centers at whole numbers
+    const vec2 pos = (ndc * 0.5 + 0.5) * vec2(renderSize) - 0.5;
+    const ivec2 base = ivec2(floor(pos));
+    const vec4 wx = cubicWeights(pos.x - float(base.x));
+    const vec4 wy = cubicWeights(pos.y - float(base.y));
+
+    vec3 col = vec3(0.0);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            const ivec2 texel = clamp(base + ivec2(x - 1, y - 1), ivec2(0), renderSize - 1);
+            col += wx[x] * wy[y] * texelFetch(scene, texel, 0).rgb;
+        }
+    }
+
+    // the negative lobes overshoot at hard edges
+    FragColor = vec4(clamp(col, 0.0, 1.0), 1.0);
+}
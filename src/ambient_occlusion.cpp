@@ -0,0 +1,91 @@
+#include "ambient_occlusion.h"
+#include <algorithm>
+#include <array>
+#include <glad/gl.h>
+
+void AmbientOcclusion::invalidate(const TerrainGen& terrainGen, const std::vector<uint32_t>& slots) {
+    constexpr int32_t size = TerrainGen::chunkSize;
+    // chunks overlap by a couple of samples
+    constexpr int32_t border = radius + 2;
+
+    for (const uint32_t slot : slots) {
+        const glm::ivec2 chunk = terrainGen.getSlotChunk(slot);
+        queue.push_back({slot, chunk, glm::ivec2(0), glm::ivec2(size)});
+    }
+
+    for (const uint32_t slot : slots) {
+        const glm::ivec2 chunk = terrainGen.getSlotChunk(slot);
+        for (int32_t dy = -1; dy <= 1; dy++) {
+            for (int32_t dx = -1; dx <= 1; dx++) {
+                const glm::ivec2 neighbourChunk = chunk + glm::ivec2(dx, dy);
+                const int32_t neighbour = terrainGen.findSlot(neighbourChunk);
+                const bool isNew = std::find(slots.begin(), slots.end(), neighbour) != slots.end();
+                if (neighbour < 0 || isNew) {
+                    continue;
+                }
+
+                // the side of the neighbour that faces the new chunk
+                const glm::ivec2 dir(dx, dy);
+                const glm::ivec2 start = glm::ivec2(dir.x < 0 ? size - border : 0, dir.y < 0 ? size - border : 0);
+                const glm::ivec2 end = glm::ivec2(dir.x > 0 ? border : size, dir.y > 0 ? border : size);
+                queue.push_back({static_cast<uint32_t>(neighbour), neighbourChunk, start, end - start});
+            }
+        }
+    }
+}
+
+void AmbientOcclusion::invalidateAll(const TerrainGen& terrainGen) {
+    queue.clear();
+    for (uint32_t slot = 0; slot < TerrainGen::getChunkCount(); slot++) {
+        queue.push_back({slot, terrainGen.getSlotChunk(slot), glm::ivec2(0), glm::ivec2(TerrainGen::chunkSize)});
+    }
+}
+
+void AmbientOcclusion::update(const ShaderProgram& aoShader, const TerrainGen& terrainGen, uint32_t vertexId,
+    uint32_t heightMapId, VertexLayout layout) {
+    if (queue.empty()) {
+        return;
+    }
+
+    aoShader.bind();
+    aoShader.set("vertexLayout", static_cast<uint32_t>(layout));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TerrainGen::vertexBinding, vertexId);
+    glBindTextureUnit(2, heightMapId);
+
+    uint32_t samples = 0;
+    while (!queue.empty() && samples < samplesPerFrame) {
+        const Region region = queue.front();
+        queue.pop_front();
+        if (terrainGen.getSlotChunk(region.slot) != region.chunk) {
+            continue;
+        }
+
+        bake(aoShader, terrainGen, region);
+        samples += region.size.x * region.size.y;
+    }
+
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void AmbientOcclusion::bake(const ShaderProgram& aoShader, const TerrainGen& terrainGen, const Region& region) const {
+    const glm::vec2 origin = terrainGen.getChunkBounds(region.slot).min;
+    std::array<int32_t, 9> layers;
+    std::array<glm::vec2, 9> offsets;
+    for (int32_t dy = -1; dy <= 1; dy++) {
+        for (int32_t dx = -1; dx <= 1; dx++) {
+            const uint32_t i = (dx + 1) + (dy + 1) * 3;
+            layers[i] = terrainGen.findSlot(region.chunk + glm::ivec2(dx, dy));
+            offsets[i] = glm::vec2(0.0f);
+            if (layers[i] >= 0) {
+                offsets[i] = (terrainGen.getChunkBounds(layers[i]).min - origin) / TerrainGen::sampleSpacing;
+            }
+        }
+    }
+
+    aoShader.set("buffIdx", region.slot);
+    aoShader.set("regionStart", glm::uvec2(region.start));
+    aoShader.set("regionSize", glm::uvec2(region.size));
+    aoShader.set("neighbourLayers", layers.data(), layers.size());
+    aoShader.set("neighbourOffsets", offsets.data(), offsets.size());
+    glDispatchCompute((region.size.x + 7) / 8, (region.size.y + 7) / 8, 1);
+}
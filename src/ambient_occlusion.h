@@ -0,0 +1,40 @@
+#pragma once
+#include "shader_program.h"
+#include "terrain_gen.h"
+#include <cstdint>
+#include <deque>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Bakes horizon based ambient occlusion into the vertices of chunks after they are generated. New chunks are baked
+// completely. The resident chunks next to them only get the border they share with the new chunk rebaked, since only
+// samples within the radius of the new chunk can see it. Work is spread over frames with a sample budget.
+class AmbientOcclusion {
+public:
+    static constexpr int32_t radius = 64; // in samples, sync with ambient_occlusion.comp
+    static constexpr uint32_t samplesPerFrame = TerrainGen::chunkSize * TerrainGen::chunkSize;
+
+    // queues the slots and the borders of their resident neighbours
+    void invalidate(const TerrainGen& terrainGen, const std::vector<uint32_t>& slots);
+    // queues every slot
+    void invalidateAll(const TerrainGen& terrainGen);
+    void clear() { queue.clear(); }
+
+    // bakes queued regions until the sample budget of the frame is used up
+    void update(const ShaderProgram& aoShader, const TerrainGen& terrainGen, uint32_t vertexId, uint32_t heightMapId,
+        VertexLayout layout);
+
+    size_t getQueuedCount() const { return queue.size(); }
+
+private:
+    struct Region {
+        uint32_t slot;
+        glm::ivec2 chunk; // chunk the region was queued for, dropped if the slot holds another one by now
+        glm::ivec2 start;
+        glm::ivec2 size;
+    };
+
+    void bake(const ShaderProgram& aoShader, const TerrainGen& terrainGen, const Region& region) const;
+
+    std::deque<Region> queue;
+};
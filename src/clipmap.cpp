@@ -0,0 +1,149 @@
+#include "clipmap.h"
+#include <glad/gl.h>
+#include <vector>
+
+// indices of the level grid without the quads in [holeStart, holeStart + holeSize)
+static void pushLevelIndices(std::vector<uint32_t>& indices, glm::ivec2 holeStart, int32_t holeSize) {
+    constexpr int32_t size = Clipmap::gridSize;
+    constexpr int32_t stripWidth = TerrainGen::indexStripWidth;
+
+    for (int32_t i0 = 0; i0 < size; i0 += stripWidth) {
+        for (int32_t j = 0; j < size; j++) {
+            for (int32_t i = i0; i < std::min(i0 + stripWidth, size); i++) {
+                const bool inHole = i >= holeStart.x && i < holeStart.x + holeSize && j >= holeStart.y &&
+                                    j < holeStart.y + holeSize;
+                if (inHole) {
+                    continue;
+                }
+
+                const uint32_t tl = i + j * (size + 1);
+                const uint32_t tr = tl + 1;
+                const uint32_t bl = tl + size + 1;
+                const uint32_t br = bl + 1;
+                indices.insert(indices.end(), {tl, bl, tr, bl, br, tr});
+            }
+        }
+    }
+}
+
+Clipmap::Clipmap() {
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+    glTextureStorage3D(texture, 1, GL_R16, textureSize, textureSize, levelCount);
+
+    // the finer level covers gridSize / 2 quads of a level, starting at gridSize / 4 or one quad further
+    std::vector<uint32_t> indices;
+    fullGrid.offset = 0;
+    pushLevelIndices(indices, glm::ivec2(0), 0);
+    fullGrid.count = indices.size();
+
+    for (uint32_t i = 0; i < rings.size(); i++) {
+        const glm::ivec2 holeStart = glm::ivec2(gridSize / 4) + glm::ivec2(i % 2, i / 2);
+        rings[i].offset = indices.size();
+        pushLevelIndices(indices, holeStart, gridSize / 2);
+        rings[i].count = indices.size() - rings[i].offset;
+    }
+
+    glCreateBuffers(1, &ebo);
+    glNamedBufferStorage(ebo, indices.size() * sizeof(uint32_t), indices.data(), 0);
+
+    // vertex positions come from gl_VertexID
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayElementBuffer(vao, ebo);
+}
+
+Clipmap::~Clipmap() {
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &ebo);
+    glDeleteVertexArrays(1, &vao);
+}
+
+glm::ivec2 Clipmap::levelOrigin(glm::vec3 camPos, uint32_t level) {
+    // snapped to every other sample, so the level is aligned with the samples of the next coarser level
+    const float spacing = static_cast<float>(1 << level);
+    const glm::ivec2 snapped(glm::floor(glm::vec2(camPos.x, camPos.z) / (2.0f * spacing)));
+    return snapped * 2 - gridSize / 2;
+}
+
+void Clipmap::genRegion(const ShaderProgram& genShader, glm::ivec2 start, glm::ivec2 size, uint32_t level) const {
+    genShader.set("regionStart", start);
+    genShader.set("regionSize", glm::uvec2(size));
+    genShader.set("level", static_cast<int32_t>(level));
+    glDispatchCompute((size.x + 7) / 8, (size.y + 7) / 8, 1);
+}
+
+void Clipmap::update(const ShaderProgram& genShader, const GenConfig& config, glm::vec3 camPos) {
+    std::array<glm::ivec2, levelCount> newOrigins;
+    bool moved = !valid;
+    for (uint32_t level = 0; level < levelCount; level++) {
+        newOrigins[level] = levelOrigin(camPos, level);
+        moved = moved || newOrigins[level] != origins[level];
+    }
+
+    if (!moved) {
+        return;
+    }
+
+    genShader.bind();
+    genShader.set("gridSize", config.gridSize);
+    genShader.set("octaves", config.octaves);
+    genShader.set("lacunarity", config.lacunarity);
+    genShader.set("gain", config.gain);
+    genShader.set("clipmapSize", textureSize);
+    glBindImageTexture(1, texture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16);
+
+    for (uint32_t level = 0; level < levelCount; level++) {
+        const glm::ivec2 origin = newOrigins[level];
+        const glm::ivec2 old = origins[level];
+        const glm::ivec2 delta = origin - old;
+
+        if (!valid || std::abs(delta.x) >= textureSize || std::abs(delta.y) >= textureSize) {
+            genRegion(genShader, origin, glm::ivec2(textureSize), level);
+            continue;
+        }
+
+        // columns that scrolled in, over the full height of the new window
+        if (delta.x > 0) {
+            genRegion(genShader, glm::ivec2(old.x + textureSize, origin.y), glm::ivec2(delta.x, textureSize), level);
+        } else if (delta.x < 0) {
+            genRegion(genShader, origin, glm::ivec2(-delta.x, textureSize), level);
+        }
+
+        // rows that scrolled in. the corner shared with the columns is generated twice
+        if (delta.y > 0) {
+            genRegion(genShader, glm::ivec2(origin.x, old.y + textureSize), glm::ivec2(textureSize, delta.y), level);
+        } else if (delta.y < 0) {
+            genRegion(genShader, origin, glm::ivec2(textureSize, -delta.y), level);
+        }
+    }
+
+    origins = newOrigins;
+    valid = true;
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void Clipmap::draw(const ShaderProgram& drawShader) const {
+    const int32_t originUniform = drawShader.findUniform("levelOrigin");
+    const int32_t levelUniform = drawShader.findUniform("level");
+    drawShader.set("levelCount", static_cast<int32_t>(levelCount));
+
+    glBindTextureUnit(3, texture);
+    glBindVertexArray(vao);
+
+    // innermost level first, so it occludes the coarser ones
+    for (uint32_t level = 0; level < levelCount; level++) {
+        IndexRange range = fullGrid;
+        if (level > 0) {
+            const glm::ivec2 hole = origins[level - 1] / 2 - origins[level] - gridSize / 4;
+            range = rings[hole.x + hole.y * 2];
+        }
+
+        drawShader.set(originUniform, origins[level]);
+        drawShader.set(levelUniform, static_cast<int32_t>(level));
+        glDrawElements(GL_TRIANGLES, range.count, GL_UNSIGNED_INT,
+            reinterpret_cast<const void*>(static_cast<uintptr_t>(range.offset) * sizeof(uint32_t)));
+    }
+}
+
+uint32_t Clipmap::getTriangleCount() const {
+    return (fullGrid.count + rings[0].count * (levelCount - 1)) / 3;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "shader_program.h"
+#include "terrain_gen.h"
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Geometry clipmap terrain. Nested square grids of gridSize quads are centered on the camera, every level with twice
+// the sample spacing of the one inside it. Each level is backed by one layer of a toroidally addressed height texture,
+// so when the camera moves only the newly exposed strips of a level are generated. The triangle count is constant
+// regardless of the view distance.
+class Clipmap {
+public:
+    static constexpr uint32_t levelCount = 8;
+    static constexpr int32_t gridSize = 256;              // quads per side of a level
+    static constexpr int32_t textureSize = gridSize + 1; // samples per side of a level
+    static_assert(gridSize % 4 == 0, "the hole of a level must be placed on even samples");
+
+    Clipmap();
+
+    Clipmap(const Clipmap& other) = delete;
+    Clipmap& operator=(const Clipmap& other) = delete;
+
+    ~Clipmap();
+
+    // generates whatever became visible since the last update
+    void update(const ShaderProgram& genShader, const GenConfig& config, glm::vec3 camPos);
+    // draws all levels with the uniforms other than the level ones already set
+    void draw(const ShaderProgram& drawShader) const;
+
+    // regenerate all levels on the next update
+    void invalidate() { valid = false; }
+
+    uint32_t getTriangleCount() const;
+
+private:
+    struct IndexRange {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    void genRegion(const ShaderProgram& genShader, glm::ivec2 start, glm::ivec2 size, uint32_t level) const;
+    // first sample of the level in samples of that level
+    static glm::ivec2 levelOrigin(glm::vec3 camPos, uint32_t level);
+
+    std::array<glm::ivec2, levelCount> origins;
+    bool valid = false;
+
+    // full grid for the innermost level, and a ring for every possible position of the hole left for the finer level
+    IndexRange fullGrid;
+    std::array<IndexRange, 4> rings;
+
+    uint32_t texture;
+    uint32_t ebo;
+    uint32_t vao;
+};
@@ -0,0 +1,149 @@
+#include "dds.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+
+// layout of the file header, see the DDS_HEADER and DDS_HEADER_DXT10 documentation
+struct DdsPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    std::array<uint32_t, 4> masks;
+};
+
+struct DdsHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    std::array<uint32_t, 11> reserved1;
+    DdsPixelFormat pixelFormat;
+    std::array<uint32_t, 4> caps;
+    uint32_t reserved2;
+};
+
+struct DdsHeaderDx10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DdsHeader) == 124 && sizeof(DdsHeaderDx10) == 20);
+
+constexpr uint32_t fourCC(const char (&code)[5]) {
+    return uint32_t(code[0]) | uint32_t(code[1]) << 8 | uint32_t(code[2]) << 16 | uint32_t(code[3]) << 24;
+}
+
+constexpr uint32_t ddsMagic = fourCC("DDS ");
+constexpr uint32_t pixelFormatFourCC = 0x4;
+constexpr uint32_t dxgiBc1 = 71;
+constexpr uint32_t dxgiBc5 = 83;
+constexpr uint32_t dxgiBc7 = 98;
+constexpr uint32_t dimensionTexture2D = 3;
+
+// clang-format off
+static GLenum formatFromDxgi(uint32_t dxgi) {
+    switch (dxgi) {
+    case dxgiBc1: return glCompressedRgbS3tcDxt1;
+    case dxgiBc5: return GL_COMPRESSED_RG_RGTC2;
+    case dxgiBc7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default: return 0;
+    }
+}
+
+static uint32_t dxgiFromFormat(GLenum format) {
+    switch (format) {
+    case glCompressedRgbS3tcDxt1: return dxgiBc1;
+    case GL_COMPRESSED_RG_RGTC2: return dxgiBc5;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM: return dxgiBc7;
+    default: return 0;
+    }
+}
+
+uint32_t ddsBlockSize(GLenum format) {
+    switch (format) {
+    case glCompressedRgbS3tcDxt1: return 8;
+    case GL_COMPRESSED_RG_RGTC2: return 16;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM: return 16;
+    default: return 0;
+    }
+}
+// clang-format on
+
+size_t ddsLevelSize(GLenum format, int32_t width, int32_t height) {
+    return size_t(std::max((width + 3) / 4, 1)) * std::max((height + 3) / 4, 1) * ddsBlockSize(format);
+}
+
+DdsImage loadDds(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    uint32_t magic = 0;
+    DdsHeader header{};
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || magic != ddsMagic || header.size != sizeof(DdsHeader)) {
+        throw std::runtime_error("not a dds file: " + path);
+    }
+
+    GLenum format = 0;
+    if (!(header.pixelFormat.flags & pixelFormatFourCC)) {
+        format = 0;
+    } else if (header.pixelFormat.fourCC == fourCC("DX10")) {
+        DdsHeaderDx10 dx10{};
+        file.read(reinterpret_cast<char*>(&dx10), sizeof(dx10));
+        if (dx10.resourceDimension == dimensionTexture2D && dx10.arraySize <= 1) {
+            format = formatFromDxgi(dx10.dxgiFormat);
+        }
+    } else if (header.pixelFormat.fourCC == fourCC("DXT1")) {
+        format = glCompressedRgbS3tcDxt1;
+    } else if (header.pixelFormat.fourCC == fourCC("ATI2") || header.pixelFormat.fourCC == fourCC("BC5U")) {
+        format = GL_COMPRESSED_RG_RGTC2;
+    }
+    if (format == 0) {
+        throw std::runtime_error("unsupported dds format: " + path);
+    }
+
+    DdsImage image{format, int32_t(header.width), int32_t(header.height), std::max(header.mipMapCount, 1u), {}};
+    size_t size = 0;
+    for (uint32_t level = 0; level < image.levels; level++) {
+        size += ddsLevelSize(format, std::max(image.width >> level, 1), std::max(image.height >> level, 1));
+    }
+
+    image.data.resize(size);
+    file.read(reinterpret_cast<char*>(image.data.data()), size);
+    if (!file) {
+        throw std::runtime_error("dds file is truncated: " + path);
+    }
+    return image;
+}
+
+void saveDds(const std::string& path, const DdsImage& image) {
+    DdsHeader header{};
+    header.size = sizeof(DdsHeader);
+    header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // caps, size, pixel format, mip count, linear size
+    header.height = image.height;
+    header.width = image.width;
+    header.pitchOrLinearSize = ddsLevelSize(image.format, image.width, image.height);
+    header.mipMapCount = image.levels;
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = pixelFormatFourCC;
+    header.pixelFormat.fourCC = fourCC("DX10");
+    header.caps[0] = 0x1000 | 0x400000 | 0x8; // texture, mipmap, complex
+
+    const DdsHeaderDx10 dx10{dxgiFromFormat(image.format), dimensionTexture2D, 0, 1, 0};
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&ddsMagic), sizeof(ddsMagic));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+    file.write(reinterpret_cast<const char*>(image.data.data()), image.data.size());
+    if (!file) {
+        throw std::runtime_error("failed to write " + path);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glad/gl.h>
+#include <string>
+#include <vector>
+
+// S3TC is an extension (GL_EXT_texture_compression_s3tc), glad is generated without extensions
+constexpr GLenum glCompressedRgbS3tcDxt1 = 0x83F0;
+
+// block compressed 2D texture with its mip chain, as stored in a .dds file
+struct DdsImage {
+    GLenum format; // GL_COMPRESSED_* internal format: BC1, BC5 or BC7
+    int32_t width;
+    int32_t height;
+    uint32_t levels;
+    std::vector<uint8_t> data; // every level after the previous one
+};
+
+// bytes of a 4x4 block, 0 for formats that are not supported
+uint32_t ddsBlockSize(GLenum format);
+size_t ddsLevelSize(GLenum format, int32_t width, int32_t height);
+
+// reads BC1, BC5 and BC7 files with a DX10 header, and DXT1 and ATI2 files with a legacy one. throws on anything else
+DdsImage loadDds(const std::string& path);
+// always writes a DX10 header
+void saveDds(const std::string& path, const DdsImage& image);
@@ -0,0 +1,95 @@
+#include "dynamic_resolution.h"
+#include <algorithm>
+#include <cmath>
+#include <glad/gl.h>
+#include <stdexcept>
+
+DynamicResolution::~DynamicResolution() {
+    if (fbo != 0) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &color);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteVertexArrays(1, &vao);
+    }
+}
+
+void DynamicResolution::allocate(glm::uvec2 size) {
+    if (fbo != 0) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &color);
+        glDeleteRenderbuffers(1, &depth);
+    } else {
+        // the fullscreen triangle comes from gl_VertexID
+        glCreateVertexArrays(1, &vao);
+    }
+
+    // the upscale reads texels directly, filtering happens in the shader
+    glCreateTextures(GL_TEXTURE_2D, 1, &color);
+    glTextureStorage2D(color, 1, GL_RGBA8, size.x, size.y);
+    glTextureParameteri(color, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(color, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glCreateRenderbuffers(1, &depth);
+    glNamedRenderbufferStorage(depth, GL_DEPTH_COMPONENT32F, size.x, size.y);
+
+    glCreateFramebuffers(1, &fbo);
+    glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, color, 0);
+    glNamedFramebufferRenderbuffer(fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if (glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        throw std::runtime_error("dynamic resolution target is incomplete");
+    }
+    targetSize = size;
+}
+
+// the gpu time scales about with the pixel count, so the scale per axis moves with the square root of the ratio. it
+// only grows once there is clear headroom, so it does not oscillate around the budget
+void DynamicResolution::adjust() {
+    const float ms = timer.getMilliseconds();
+    if (!config.enabled) {
+        scale = config.maxScale;
+    } else if (ms > 0.0f && (ms > config.budgetMs || ms < config.budgetMs * 0.85f)) {
+        // a fraction of the step per frame, the timer lags behind by a few frames
+        const float target = scale * std::sqrt(config.budgetMs / ms);
+        scale += (target - scale) * 0.1f;
+    }
+    scale = std::clamp(scale, config.minScale, config.maxScale);
+}
+
+void DynamicResolution::begin(glm::uvec2 windowSize) {
+    this->windowSize = windowSize;
+    const glm::uvec2 maxSize = glm::max(glm::uvec2(glm::ceil(glm::vec2(windowSize) * config.maxScale)), glm::uvec2(1));
+    if (maxSize != targetSize) {
+        allocate(maxSize);
+    }
+
+    adjust();
+    const glm::uvec2 size = glm::uvec2(glm::vec2(windowSize) * scale) / sizeGranularity * sizeGranularity;
+    renderSize = glm::min(glm::max(size, glm::uvec2(sizeGranularity)), targetSize);
+    if (!config.enabled) {
+        // the whole target, at a max scale of 1 the upscale is an exact copy
+        renderSize = targetSize;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, renderSize.x, renderSize.y);
+}
+
+void DynamicResolution::beginScene() {
+    timer.begin();
+}
+
+void DynamicResolution::upscale(const ShaderProgram& upscaleShader) {
+    timer.end();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, windowSize.x, windowSize.y);
+    glDisable(GL_DEPTH_TEST);
+
+    upscaleShader.bind();
+    upscaleShader.set("renderSize", glm::ivec2(renderSize));
+    glBindTextureUnit(0, color);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "gpu_timer.h"
+#include "shader_program.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+
+struct ResolutionConfig {
+    bool enabled = false;
+    float budgetMs = 14.0f; // gpu time of the scene, a bit below a 60hz frame so vsync does not drop to half rate
+    float minScale = 0.5f;  // of the window size per axis
+    float maxScale = 1.0f;
+};
+
+// Renders the scene into an offscreen target whose resolution follows the gpu time of earlier frames, so a heavy view
+// costs resolution instead of frame rate. The target is allocated at the largest scale and only its lower left corner
+// is used, changing the scale never reallocates it. The result is upscaled into the default framebuffer with a
+// bicubic filter, anything drawn after that (the gui) is at native resolution.
+class DynamicResolution {
+public:
+    static constexpr uint32_t sizeGranularity = 8; // render sizes are multiples of this, to not change every frame
+
+    DynamicResolution() = default;
+
+    DynamicResolution(const DynamicResolution& other) = delete;
+    DynamicResolution& operator=(const DynamicResolution& other) = delete;
+
+    ~DynamicResolution();
+
+    // adjusts the scale, binds the target and sets the viewport to the render size. reallocates the target when the
+    // window size changes
+    void begin(glm::uvec2 windowSize);
+    // starts timing the passes drawn at the render size. generation and baking before them cost the same at any scale
+    void beginScene();
+    // ends the timing, binds the default framebuffer and resamples the render size part of the target onto all of it
+    void upscale(const ShaderProgram& upscaleShader);
+
+    void setConfig(const ResolutionConfig& config) { this->config = config; }
+
+    glm::uvec2 getRenderSize() const { return renderSize; }
+    float getScale() const { return scale; }
+    float getSceneMilliseconds() const { return timer.getAverageMilliseconds(); }
+
+private:
+    void allocate(glm::uvec2 size);
+    void adjust();
+
+    ResolutionConfig config;
+    float scale = 1.0f;
+    GpuTimer timer;
+
+    glm::uvec2 windowSize{0, 0};
+    glm::uvec2 targetSize{0, 0};
+    glm::uvec2 renderSize{0, 0};
+    uint32_t fbo = 0;
+    uint32_t color = 0;
+    uint32_t depth = 0;
+    uint32_t vao = 0;
+};
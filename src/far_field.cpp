@@ -0,0 +1,63 @@
+#include "far_field.h"
+#include <algorithm>
+#include <array>
+#include <glad/gl.h>
+
+FarField::FarField(uint32_t chunkCount) {
+    constexpr uint32_t size = TerrainGen::chunkSize / 2;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &pyramid);
+    glTextureStorage3D(pyramid, levelCount, GL_R16, size, size, chunkCount);
+    glTextureParameteri(pyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // the fullscreen triangle comes from gl_VertexID
+    glCreateVertexArrays(1, &vao);
+}
+
+FarField::~FarField() {
+    glDeleteTextures(1, &pyramid);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void FarField::update(
+    const ShaderProgram& pyramidShader, uint32_t heightMapId, const std::vector<uint32_t>& slots) const {
+    if (slots.empty()) {
+        return;
+    }
+
+    pyramidShader.bind();
+    glBindTextureUnit(2, heightMapId);
+    const int32_t layerUniform = pyramidShader.findUniform("layer");
+    const int32_t levelUniform = pyramidShader.findUniform("level");
+
+    // level by level for all slots, so there is one barrier per level
+    for (uint32_t level = 1; level <= levelCount; level++) {
+        const uint32_t size = TerrainGen::chunkSize >> level;
+        glBindImageTexture(0, pyramid, std::max(level, 2u) - 2, GL_TRUE, 0, GL_READ_ONLY, GL_R16);
+        glBindImageTexture(1, pyramid, level - 1, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16);
+        pyramidShader.set(levelUniform, static_cast<int32_t>(level));
+        for (const uint32_t slot : slots) {
+            pyramidShader.set(layerUniform, slot);
+            glDispatchCompute((size + 7) / 8, (size + 7) / 8, 1);
+        }
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void FarField::draw(const ShaderProgram& marchShader, uint32_t heightMapId, const std::vector<FarChunk>& chunks) const {
+    // origin, distance and layer of every chunk
+    std::array<glm::vec4, maxChunks> packed;
+    const uint32_t count = std::min<size_t>(chunks.size(), maxChunks);
+    for (uint32_t i = 0; i < count; i++) {
+        packed[i] = glm::vec4(chunks[i].origin, chunks[i].distance, chunks[i].slot);
+    }
+
+    marchShader.set("farChunkCount", static_cast<int32_t>(count));
+    marchShader.set("farChunks", packed.data(), count);
+    glBindTextureUnit(2, heightMapId);
+    glBindTextureUnit(4, pyramid);
+
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
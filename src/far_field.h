@@ -0,0 +1,40 @@
+#pragma once
+#include "shader_program.h"
+#include "terrain_gen.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// a chunk that is ray marched instead of rasterized
+struct FarChunk {
+    glm::vec2 origin;
+    float distance; // horizontal distance from the camera to the closest point of the chunk
+    uint32_t slot;
+};
+
+// Ray marched far field. Keeps a pyramid of maximum heights per height map layer, which lets a fullscreen pass skip
+// over empty space. The cost of far chunks scales with the pixels they cover instead of with their triangles.
+// Only resident chunks can be marched, as they read the height map layers of their vertex buffer slots, so this
+// changes how the outer chunks are drawn but not how far the terrain reaches.
+class FarField {
+public:
+    static constexpr uint32_t levelCount = 10; // pyramid levels above the height map, chunkSize / 2 down to 1
+    static constexpr uint32_t maxChunks = 64;  // sync with far_field.frag
+    static_assert((TerrainGen::chunkSize >> levelCount) == 1, "the top level must cover the whole chunk");
+
+    FarField(uint32_t chunkCount);
+
+    FarField(const FarField& other) = delete;
+    FarField& operator=(const FarField& other) = delete;
+
+    ~FarField();
+
+    // rebuilds the pyramids of the slots from their height map layers
+    void update(const ShaderProgram& pyramidShader, uint32_t heightMapId, const std::vector<uint32_t>& slots) const;
+    // chunks must be sorted front to back. uniforms other than the chunk list must already be set
+    void draw(const ShaderProgram& marchShader, uint32_t heightMapId, const std::vector<FarChunk>& chunks) const;
+
+private:
+    uint32_t pyramid;
+    uint32_t vao;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// std140 layout of the FrameBlock uniform block, sync with res/shaders/frame_block.glsl. members are ordered so
+// nothing is padded
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::mat4 viewProj;
+    glm::vec3 camPos;
+    float heightScale;
+    glm::vec2 fogDistance;
+    float heightPower;
+    float padding;
+};
+
+static_assert(sizeof(FrameData) == 224, "FrameData must match the std140 layout of FrameBlock");
+
+// binding point of FrameBlock
+constexpr uint32_t frameDataBinding = 0;
@@ -0,0 +1,80 @@
+#include "frame_limiter.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h> // includes timeBeginPeriod, unlike the lean version
+#endif
+
+// the scheduler tick only matters while the limiter sleeps
+static void setFineTimer(bool fine) {
+#ifdef _WIN32
+    if (fine) {
+        timeBeginPeriod(1);
+    } else {
+        timeEndPeriod(1);
+    }
+#else
+    (void)fine;
+#endif
+}
+
+FrameLimiter::~FrameLimiter() {
+    if (targetFps > 0.0f) {
+        setFineTimer(false);
+    }
+}
+
+void FrameLimiter::setTargetFps(float fps) {
+    if ((fps > 0.0f) != (targetFps > 0.0f)) {
+        setFineTimer(fps > 0.0f);
+    }
+    targetFps = fps;
+}
+
+void FrameLimiter::wait() {
+    Clock::time_point now = Clock::now();
+    if (targetFps > 0.0f && last) {
+        // deadlines follow each other, so a frame that wakes up late does not push all later ones back. after a
+        // frame that missed its deadline entirely the schedule starts over
+        const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+        deadline = now - deadline > period ? now : deadline + period;
+
+        if (deadline - now > spinTime) {
+            std::this_thread::sleep_for(deadline - now - spinTime);
+        }
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        now = Clock::now();
+    } else {
+        deadline = now;
+    }
+
+    if (last) {
+        record(std::chrono::duration<float, std::milli>(now - *last).count());
+    }
+    last = now;
+}
+
+void FrameLimiter::record(float ms) {
+    intervals[next] = ms;
+    next = (next + 1) % historySize;
+    intervalCount = std::min(intervalCount + 1, historySize);
+
+    float sum = 0.0f;
+    maxMs = 0.0f;
+    for (uint32_t i = 0; i < intervalCount; i++) {
+        sum += intervals[i];
+        maxMs = std::max(maxMs, intervals[i]);
+    }
+    averageMs = sum / intervalCount;
+
+    float variance = 0.0f;
+    for (uint32_t i = 0; i < intervalCount; i++) {
+        variance += (intervals[i] - averageMs) * (intervals[i] - averageMs);
+    }
+    jitterMs = std::sqrt(variance / intervalCount);
+}
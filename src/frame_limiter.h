@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+// Caps the frame rate at a target below the refresh rate and measures how evenly frames are paced. Sleeping alone
+// overshoots by up to a scheduler tick, so it sleeps until shortly before the deadline and spins the rest. On windows
+// the tick is 15.6 ms by default, it is raised to 1 ms while a target is set.
+class FrameLimiter {
+public:
+    static constexpr uint32_t historySize = 120;
+
+    FrameLimiter() = default;
+
+    FrameLimiter(const FrameLimiter& other) = delete;
+    FrameLimiter& operator=(const FrameLimiter& other) = delete;
+
+    ~FrameLimiter();
+
+    // call once per frame after presenting. waits for the rest of the frame period and records the frame interval
+    void wait();
+    // the next interval is not a frame, e.g. after idling
+    void reset() { last.reset(); }
+
+    // 0 does not wait
+    void setTargetFps(float fps);
+    float getTargetFps() const { return targetFps; }
+
+    // over the last historySize frames
+    float getAverageMilliseconds() const { return averageMs; }
+    // standard deviation of the frame intervals
+    float getJitterMilliseconds() const { return jitterMs; }
+    float getMaxMilliseconds() const { return maxMs; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    // sleeps are only trusted to end within this much of their target
+    static constexpr std::chrono::microseconds spinTime{2000};
+
+    void record(float ms);
+
+    float targetFps = 0.0f;
+    std::optional<Clock::time_point> last;
+    Clock::time_point deadline;
+
+    std::array<float, historySize> intervals{};
+    uint32_t intervalCount = 0;
+    uint32_t next = 0;
+    float averageMs = 0.0f;
+    float jitterMs = 0.0f;
+    float maxMs = 0.0f;
+};
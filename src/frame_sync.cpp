@@ -0,0 +1,49 @@
+#include "frame_sync.h"
+#include <algorithm>
+#include <chrono>
+
+FrameSync::FrameSync(uint32_t frameCount)
+    : frameCount(frameCount), framesInFlight(frameCount), fences(frameCount, nullptr) {}
+
+FrameSync::~FrameSync() {
+    for (const GLsync fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+}
+
+void FrameSync::setFramesInFlight(uint32_t count) {
+    framesInFlight = std::clamp(count, 1u, frameCount);
+}
+
+void FrameSync::beginFrame() {
+    const auto start = std::chrono::steady_clock::now();
+    frame++;
+
+    // oldest first, which is the frame that used the region of this one. the fences signal in order, so after the
+    // first real wait the rest return immediately
+    for (uint32_t age = std::min<uint64_t>(frameCount, frame); age >= framesInFlight; age--) {
+        wait((frame - age) % frameCount);
+    }
+
+    const std::chrono::duration<float, std::milli> waited = std::chrono::steady_clock::now() - start;
+    lastWaitMs = waited.count();
+    averageWaitMs = averageWaitMs * 0.95f + lastWaitMs * 0.05f;
+}
+
+void FrameSync::endFrame() {
+    fences[getFrameIndex()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void FrameSync::wait(uint32_t index) {
+    GLsync& fence = fences[index];
+    if (!fence) {
+        return;
+    }
+
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
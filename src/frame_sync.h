@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <glad/gl.h>
+#include <vector>
+
+// Controls how far the cpu records ahead of the gpu. Every frame is fenced when it is submitted and beginFrame waits
+// until the frame the given number of frames back is done. Buffers with per frame data keep one region per frame
+// count and write the one of getFrameIndex(), which the gpu is done reading by then.
+class FrameSync {
+public:
+    FrameSync(uint32_t frameCount = 3);
+
+    FrameSync(const FrameSync& other) = delete;
+    FrameSync& operator=(const FrameSync& other) = delete;
+
+    ~FrameSync();
+
+    // waits until at most framesInFlight - 1 earlier frames are still on the gpu
+    void beginFrame();
+    // fences the frame, call after its last command
+    void endFrame();
+
+    // between 1 and the frame count
+    void setFramesInFlight(uint32_t count);
+
+    uint32_t getFrameCount() const { return frameCount; }
+    uint32_t getFramesInFlight() const { return framesInFlight; }
+    // region of the current frame in buffers with per frame data
+    uint32_t getFrameIndex() const { return frame % frameCount; }
+
+    // cpu time the last beginFrame spent waiting
+    float getWaitMilliseconds() const { return lastWaitMs; }
+    // exponential moving average of the wait times
+    float getAverageWaitMilliseconds() const { return averageWaitMs; }
+
+private:
+    void wait(uint32_t index);
+
+    uint32_t frameCount;
+    uint32_t framesInFlight;
+    uint64_t frame = 0;
+    std::vector<GLsync> fences;
+
+    float lastWaitMs = 0.0f;
+    float averageWaitMs = 0.0f;
+};
@@ -0,0 +1,49 @@
+#include "gpu_timer.h"
+#include <glad/gl.h>
+
+GpuTimer::GpuTimer() {
+    glCreateQueries(GL_TIMESTAMP, queries.size(), queries.data());
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(queries.size(), queries.data());
+}
+
+void GpuTimer::begin() {
+    for (uint32_t i = 0; i < latency; i++) {
+        if (pending[i]) {
+            collect(i);
+        }
+    }
+
+    // a result that is still not there a few frames later gets dropped instead of stalling on it
+    pending[current] = false;
+    glQueryCounter(queries[current * 2], GL_TIMESTAMP);
+}
+
+void GpuTimer::end() {
+    glQueryCounter(queries[current * 2 + 1], GL_TIMESTAMP);
+    pending[current] = true;
+    current = (current + 1) % latency;
+}
+
+void GpuTimer::discard() {
+    glQueryCounter(queries[current * 2 + 1], GL_TIMESTAMP);
+    pending[current] = false;
+}
+
+void GpuTimer::collect(uint32_t slot) {
+    int32_t available = GL_FALSE;
+    glGetQueryObjectiv(queries[slot * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return;
+    }
+    pending[slot] = false;
+
+    uint64_t start, stop;
+    glGetQueryObjectui64v(queries[slot * 2], GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(queries[slot * 2 + 1], GL_QUERY_RESULT, &stop);
+
+    lastMs = static_cast<float>(stop - start) / 1e6f;
+    averageMs = averageMs == 0.0f ? lastMs : averageMs * 0.95f + lastMs * 0.05f;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Measures gpu time between begin and end with timestamp queries. Results are read back a few frames later so the
+// cpu never waits on the gpu.
+class GpuTimer {
+public:
+    GpuTimer();
+
+    GpuTimer(const GpuTimer& other) = delete;
+    GpuTimer& operator=(const GpuTimer& other) = delete;
+
+    ~GpuTimer();
+
+    void begin();
+    void end();
+    // the timestamps since begin are not interesting, e.g. because nothing was submitted
+    void discard();
+
+    // last measured time
+    float getMilliseconds() const { return lastMs; }
+    // exponential moving average of the measured times
+    float getAverageMilliseconds() const { return averageMs; }
+
+private:
+    static constexpr uint32_t latency = 4;
+
+    void collect(uint32_t slot);
+
+    std::array<uint32_t, latency * 2> queries;
+    std::array<bool, latency> pending{};
+    uint32_t current = 0;
+    float lastMs = 0.0f;
+    float averageMs = 0.0f;
+};
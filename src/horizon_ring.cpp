@@ -0,0 +1,95 @@
+#include "horizon_ring.h"
+#include <algorithm>
+#include <glad/gl.h>
+
+HorizonRing::HorizonRing() {
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+    glTextureStorage3D(texture, 1, GL_R16, samplesPerSide, samplesPerSide, chunkCount);
+
+    // one grid shared by all chunks, same strips as the chunk index buffer
+    std::vector<uint32_t> indices;
+    constexpr int32_t stripWidth = TerrainGen::indexStripWidth;
+    for (int32_t i0 = 0; i0 < quadsPerSide; i0 += stripWidth) {
+        for (int32_t j = 0; j < quadsPerSide; j++) {
+            for (int32_t i = i0; i < std::min(i0 + stripWidth, quadsPerSide); i++) {
+                const uint32_t tl = i + j * samplesPerSide;
+                const uint32_t tr = tl + 1;
+                const uint32_t bl = tl + samplesPerSide;
+                const uint32_t br = bl + 1;
+                indices.insert(indices.end(), {tl, bl, tr, bl, br, tr});
+            }
+        }
+    }
+    indexCount = indices.size();
+
+    glCreateBuffers(1, &ebo);
+    glNamedBufferStorage(ebo, indices.size() * sizeof(uint32_t), indices.data(), 0);
+
+    // vertex positions come from gl_VertexID and gl_InstanceID
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayElementBuffer(vao, ebo);
+}
+
+HorizonRing::~HorizonRing() {
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &ebo);
+    glDeleteVertexArrays(1, &vao);
+}
+
+uint32_t HorizonRing::layerOf(glm::ivec2 chunk) {
+    const glm::ivec2 wrapped = ((chunk % chunksPerSide) + chunksPerSide) % chunksPerSide;
+    return wrapped.x + wrapped.y * chunksPerSide;
+}
+
+void HorizonRing::update(const ShaderProgram& genShader, const GenConfig& config, glm::vec3 camPos) {
+    const glm::ivec2 newCenter(glm::floor(glm::vec2(camPos.x, camPos.z) / static_cast<float>(chunkExtent)));
+    if (valid && newCenter == center) {
+        return;
+    }
+
+    // octaves with features smaller than a sample would only alias
+    uint32_t octaves = 1;
+    float featureSize = config.gridSize / config.lacunarity;
+    while (octaves < config.octaves && featureSize >= sampleSpacing) {
+        octaves++;
+        featureSize /= config.lacunarity;
+    }
+    octaves = std::min(octaves, config.octaves);
+
+    genShader.bind();
+    genShader.set("gridSize", config.gridSize);
+    genShader.set("octaves", octaves);
+    genShader.set("lacunarity", config.lacunarity);
+    genShader.set("gain", config.gain);
+    genShader.set("horizonSpacing", sampleSpacing);
+    glBindImageTexture(1, texture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16);
+
+    const int32_t originUniform = genShader.findUniform("horizonOrigin");
+    const int32_t layerUniform = genShader.findUniform("horizonLayer");
+    for (int32_t y = -radius; y <= radius; y++) {
+        for (int32_t x = -radius; x <= radius; x++) {
+            const glm::ivec2 chunk = newCenter + glm::ivec2(x, y);
+            const uint32_t layer = layerOf(chunk);
+            if (valid && layerChunks[layer] == chunk) {
+                continue;
+            }
+
+            const glm::ivec2 origin = chunk * chunkExtent;
+            genShader.set(originUniform, origin);
+            genShader.set(layerUniform, layer);
+            glDispatchCompute((samplesPerSide + 7) / 8, (samplesPerSide + 7) / 8, 1);
+            layerChunks[layer] = chunk;
+        }
+    }
+
+    center = newCenter;
+    valid = true;
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void HorizonRing::draw(const ShaderProgram& drawShader) const {
+    drawShader.set("horizonCenter", center);
+    glBindTextureUnit(5, texture);
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, chunkCount);
+}
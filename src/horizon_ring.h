@@ -0,0 +1,49 @@
+#pragma once
+#include "shader_program.h"
+#include "terrain_gen.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Coarse terrain beyond the streamed chunks. A square of large chunks with few samples and octaves is kept around the
+// camera, every chunk in the layer of a toroidally addressed height texture, so only chunks that come into range are
+// generated when the camera moves. Where the streamed chunks are the ring is cut away in the fragment shader.
+class HorizonRing {
+public:
+    static constexpr int32_t quadsPerSide = 64;
+    static constexpr int32_t samplesPerSide = quadsPerSide + 1;
+    static constexpr int32_t chunkExtent = TerrainGen::chunkSize * 4; // world units per side of a coarse chunk
+    static constexpr int32_t sampleSpacing = chunkExtent / quadsPerSide;
+    static constexpr int32_t radius = 10; // coarse chunks around the one of the camera, sync with horizon.vert
+    static constexpr int32_t chunksPerSide = radius * 2 + 1;
+    static constexpr uint32_t chunkCount = chunksPerSide * chunksPerSide;
+
+    HorizonRing();
+
+    HorizonRing(const HorizonRing& other) = delete;
+    HorizonRing& operator=(const HorizonRing& other) = delete;
+
+    ~HorizonRing();
+
+    // generates the coarse chunks that came into range
+    void update(const ShaderProgram& genShader, const GenConfig& config, glm::vec3 camPos);
+    // draws all coarse chunks with the uniforms other than the ring ones already set
+    void draw(const ShaderProgram& drawShader) const;
+
+    // regenerate all chunks on the next update
+    void invalidate() { valid = false; }
+
+    uint32_t getTriangleCount() const { return indexCount / 3 * chunkCount; }
+
+private:
+    static uint32_t layerOf(glm::ivec2 chunk);
+
+    glm::ivec2 center{0};
+    bool valid = false;
+    std::vector<glm::ivec2> layerChunks = std::vector<glm::ivec2>(chunkCount); // chunk stored in every layer
+
+    uint32_t indexCount;
+    uint32_t texture;
+    uint32_t ebo;
+    uint32_t vao;
+};
@@ -1,22 +1,46 @@
+#include "ambient_occlusion.h"
 #include "camera.h"
+#include "clipmap.h"
+#include "dynamic_resolution.h"
+#include "far_field.h"
+#include "frame_data.h"
+#include "frame_limiter.h"
+#include "frame_sync.h"
+#include "gpu_timer.h"
+#include "horizon_ring.h"
 #include "imgui_wrapper.h"
 #include "input.h"
+#include "occlusion_culler.h"
+#include "rtin.h"
+#include "shadow_cascades.h"
 #include "shader.h"
 #include "shader_program.h"
 #include "terrain_gen.h"
+#include "texture_loader.h"
+#include "uniform_ring.h"
 #include "util.h"
+#include "virtual_texture.h"
 #include "window.h"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <fstream>
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
+#include <iostream>
+#include <numeric>
 #include <sstream>
-#include <stb_image.h>
+
+enum class TerrainMode {
+    Indexed,      // full resolution grid per chunk
+    Tessellation, // coarse patches per chunk, tessellated by screen space edge length
+    Clipmap,      // nested grids around the camera instead of chunks
+};
 
 // needed so the glfw context doesnt get destroyed before the opengl resources are freed
 struct GlfwContext {
@@ -58,6 +82,7 @@ int main() {
     if (!gladLoadGL(static_cast<GLADloadfunc>(glfwGetProcAddress))) {
         throw std::runtime_error("failed to initialize glad");
     }
+    ShaderProgram::initParallelCompile(static_cast<GLADloadfunc>(glfwGetProcAddress));
 
     Gui::init(window.handle());
 
@@ -78,111 +103,232 @@ int main() {
         return sstr.str();
     };
 
+    // all programs are submitted before anything else is set up, so the driver can compile them in the meantime
     const std::string compSource = readFile("res/shaders/terrain.comp");
-    const ShaderProgram compProgram({Shader(compSource, ShaderType::Compute)});
-
-    uint32_t vbo;
-    glCreateBuffers(1, &vbo);
-    glNamedBufferStorage(vbo, TerrainGen::getVertexBufferSize(), nullptr, GL_DYNAMIC_STORAGE_BIT);
-    TerrainGen terrainGen;
-    GenConfig genConfig{};
-
-    const auto indices = TerrainGen::genHeightIndices();
-    uint32_t ebo;
-    glCreateBuffers(1, &ebo);
-    glNamedBufferData(ebo, TerrainGen::getIndexBufferSize(), indices.data(), GL_STATIC_DRAW);
-
-    uint32_t vao;
-    glCreateVertexArrays(1, &vao);
-    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(Vertex));
-    glVertexArrayElementBuffer(vao, ebo);
-    glEnableVertexArrayAttrib(vao, 0);
-    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribBinding(vao, 0, 0);
+    ShaderProgram compProgram({Shader(compSource, ShaderType::Compute)});
+    ShaderProgram clipmapGenProgram({Shader(compSource, ShaderType::Compute, {"CLIPMAP"})});
+    ShaderProgram horizonGenProgram({Shader(compSource, ShaderType::Compute, {"HORIZON"})});
 
     const std::string vertSrc = readFile("res/shaders/shader.vert");
     const std::string fragSrc = readFile("res/shaders/shader.frag");
-    const ShaderProgram program({
+    ShaderProgram program({
         Shader(vertSrc, ShaderType::Vertex),
         Shader(fragSrc, ShaderType::Fragment),
     });
 
+    ShaderProgram virtualProgram({
+        Shader(vertSrc, ShaderType::Vertex),
+        Shader(fragSrc, ShaderType::Fragment, {"VIRTUAL_TEXTURE"}),
+    });
+
+    const std::string depthFragSrc = readFile("res/shaders/depth.frag");
+    ShaderProgram depthProgram({
+        Shader(vertSrc, ShaderType::Vertex, {"DEPTH_ONLY"}),
+        Shader(depthFragSrc, ShaderType::Fragment),
+    });
+
+    const std::string boundsVertSrc = readFile("res/shaders/bounds.vert");
+    ShaderProgram boundsProgram({
+        Shader(boundsVertSrc, ShaderType::Vertex),
+        Shader(depthFragSrc, ShaderType::Fragment),
+    });
+
+    const std::string tessVertSrc = readFile("res/shaders/terrain_tess.vert");
+    const std::string tessControlSrc = readFile("res/shaders/terrain_tess.tesc");
+    const std::string tessEvalSrc = readFile("res/shaders/terrain_tess.tese");
+    ShaderProgram tessProgram({
+        Shader(tessVertSrc, ShaderType::Vertex),
+        Shader(tessControlSrc, ShaderType::TessControl),
+        Shader(tessEvalSrc, ShaderType::TessEvaluation),
+        Shader(fragSrc, ShaderType::Fragment),
+    });
+    ShaderProgram virtualTessProgram({
+        Shader(tessVertSrc, ShaderType::Vertex),
+        Shader(tessControlSrc, ShaderType::TessControl),
+        Shader(tessEvalSrc, ShaderType::TessEvaluation),
+        Shader(fragSrc, ShaderType::Fragment, {"VIRTUAL_TEXTURE"}),
+    });
+
+    const std::string virtualPageSrc = readFile("res/shaders/virtual_page.comp");
+    ShaderProgram virtualPageProgram({Shader(virtualPageSrc, ShaderType::Compute)});
+
+    const std::string rtinErrorSrc = readFile("res/shaders/rtin_error.comp");
+    ShaderProgram rtinErrorProgram({Shader(rtinErrorSrc, ShaderType::Compute)});
+
+    const std::string ambientOcclusionSrc = readFile("res/shaders/ambient_occlusion.comp");
+    ShaderProgram ambientOcclusionProgram({Shader(ambientOcclusionSrc, ShaderType::Compute)});
+
+    const std::string horizonVertSrc = readFile("res/shaders/horizon.vert");
+    ShaderProgram horizonProgram({
+        Shader(horizonVertSrc, ShaderType::Vertex),
+        Shader(fragSrc, ShaderType::Fragment, {"HORIZON"}),
+    });
+
+    const std::string maxHeightSrc = readFile("res/shaders/max_height.comp");
+    ShaderProgram maxHeightProgram({Shader(maxHeightSrc, ShaderType::Compute)});
+
+    const std::string farFieldVertSrc = readFile("res/shaders/far_field.vert");
+    const std::string farFieldFragSrc = readFile("res/shaders/far_field.frag");
+    ShaderProgram farFieldProgram({
+        Shader(farFieldVertSrc, ShaderType::Vertex),
+        Shader(farFieldFragSrc, ShaderType::Fragment),
+    });
+
+    // the far field vertex shader is only a fullscreen triangle
+    const std::string upscaleFragSrc = readFile("res/shaders/upscale.frag");
+    ShaderProgram upscaleProgram({
+        Shader(farFieldVertSrc, ShaderType::Vertex),
+        Shader(upscaleFragSrc, ShaderType::Fragment),
+    });
+
+    const std::string clipmapVertSrc = readFile("res/shaders/clipmap.vert");
+    ShaderProgram clipmapProgram({
+        Shader(clipmapVertSrc, ShaderType::Vertex),
+        Shader(fragSrc, ShaderType::Fragment),
+    });
+
     const std::string skyboxVertSrc = readFile("res/shaders/skybox.vert");
     const std::string skyboxFragSrc = readFile("res/shaders/skybox.frag");
-    const ShaderProgram skyboxProgram({
+    ShaderProgram skyboxProgram({
         Shader(skyboxVertSrc, ShaderType::Vertex),
         Shader(skyboxFragSrc, ShaderType::Fragment),
     });
 
-    uint32_t rockTexture;
-    glCreateTextures(GL_TEXTURE_2D, 1, &rockTexture);
+    uint32_t vbo;
+    glCreateBuffers(1, &vbo);
+    glNamedBufferStorage(vbo, TerrainGen::getVertexBufferSize(), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    TerrainGen terrainGen;
+    GenConfig genConfig{};
+
+    IndexOrder indexOrder = IndexOrder::Strips;
+    VertexLayout vertexLayout = VertexLayout::RowMajor;
+
+    // one layer per vertex buffer slot, sampled by the tessellation mode
+    uint32_t heightMap;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &heightMap);
+    glTextureStorage3D(heightMap, 1, GL_R16, TerrainGen::chunkSize, TerrainGen::chunkSize, TerrainGen::getChunkCount());
+    glTextureParameteri(heightMap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(heightMap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(heightMap, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(heightMap, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // material weights decided at generation, same layers as the height map
+    uint32_t splatMap;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &splatMap);
+    glTextureStorage3D(
+        splatMap, 1, GL_RGBA8, TerrainGen::chunkSize, TerrainGen::chunkSize, TerrainGen::getChunkCount());
+    glTextureParameteri(splatMap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(splatMap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(splatMap, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(splatMap, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // all chunk vaos read the same vertex buffer, only the index buffer differs
+    const auto createChunkVao = [vbo](uint32_t indexBuffer) {
+        uint32_t vertexArray;
+        glCreateVertexArrays(1, &vertexArray);
+        glVertexArrayVertexBuffer(vertexArray, 0, vbo, 0, sizeof(Vertex));
+        glVertexArrayElementBuffer(vertexArray, indexBuffer);
+        glEnableVertexArrayAttrib(vertexArray, 0);
+        glVertexArrayAttribFormat(vertexArray, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, pos));
+        glVertexArrayAttribBinding(vertexArray, 0, 0);
+        glEnableVertexArrayAttrib(vertexArray, 1);
+        glVertexArrayAttribIFormat(vertexArray, 1, 1, GL_UNSIGNED_INT, offsetof(Vertex, normal));
+        glVertexArrayAttribBinding(vertexArray, 1, 0);
+        return vertexArray;
+    };
 
-    glTextureParameteri(rockTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTextureParameteri(rockTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTextureParameteri(rockTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTextureParameteri(rockTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // the full 32 bit index buffer (~25 MB) only exists while the untiled path is selected
+    uint32_t ebo = 0;
+    uint32_t vao = 0;
+    const auto uploadHeightIndices = [&]() {
+        const auto indices = TerrainGen::genHeightIndices(indexOrder, vertexLayout);
+        if (ebo == 0) {
+            glCreateBuffers(1, &ebo);
+            glNamedBufferData(ebo, TerrainGen::getIndexBufferSize(), indices.data(), GL_STATIC_DRAW);
+            vao = createChunkVao(ebo);
+        } else {
+            glNamedBufferSubData(ebo, 0, TerrainGen::getIndexBufferSize(), indices.data());
+        }
+    };
+    const auto freeHeightIndices = [&]() {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &ebo);
+        vao = 0;
+        ebo = 0;
+    };
+    uploadHeightIndices();
 
-    int width, height, numChannels;
-    stbi_set_flip_vertically_on_load(true);
-    uint8_t* data = stbi_load("res/textures/rock.jpg", &width, &height, &numChannels, 0);
-    if (!data) {
-        throw std::runtime_error("failed to load image from disk");
-    }
+    // 16 bit tiles (~0.8 MB), morton layout only
+    const auto tileIndices = TerrainGen::genTileIndices(indexOrder);
+    uint32_t tileEbo;
+    glCreateBuffers(1, &tileEbo);
+    glNamedBufferData(tileEbo, tileIndices.size() * sizeof(uint16_t), tileIndices.data(), GL_STATIC_DRAW);
 
-    glTextureStorage2D(rockTexture, 1, GL_RGB8, width, height);
-    glTextureSubImage2D(rockTexture, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateTextureMipmap(rockTexture);
+    const auto seamIndices = TerrainGen::genSeamIndices();
+    uint32_t seamEbo;
+    glCreateBuffers(1, &seamEbo);
+    glNamedBufferStorage(seamEbo, seamIndices.size() * sizeof(uint32_t), seamIndices.data(), 0);
 
-    uint32_t grassTexture;
-    glCreateTextures(GL_TEXTURE_2D, 1, &grassTexture);
+    const uint32_t tileVao = createChunkVao(tileEbo);
 
-    glTextureParameteri(grassTexture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTextureParameteri(grassTexture, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTextureParameteri(grassTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTextureParameteri(grassTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const uint32_t seamVao = createChunkVao(seamEbo);
 
-    // int width, height, numChannels;
-    stbi_set_flip_vertically_on_load(true);
-    data = stbi_load("res/textures/grass3.jpg", &width, &height, &numChannels, 0);
-    if (!data) {
-        throw std::runtime_error("failed to load image from disk");
+    constexpr uint32_t tilesPerRow = TerrainGen::chunkSize / TerrainGen::tileSize;
+    std::array<int32_t, TerrainGen::tilesPerChunk> tileBaseVertices;
+    for (uint32_t i = 0; i < TerrainGen::tilesPerChunk; i++) {
+        const uint32_t x = (i % tilesPerRow) * TerrainGen::tileSize;
+        const uint32_t y = (i / tilesPerRow) * TerrainGen::tileSize;
+        tileBaseVertices[i] = TerrainGen::vertexIndex(x, y, VertexLayout::Morton);
     }
 
-    glTextureStorage2D(grassTexture, 1, GL_RGB8, width, height);
-    glTextureSubImage2D(grassTexture, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateTextureMipmap(grassTexture);
-
-    stbi_image_free(data);
+    std::array<int32_t, TerrainGen::tilesPerChunk> tileCounts;
+    tileCounts.fill(TerrainGen::tileElemCount);
+    const std::array<const void*, TerrainGen::tilesPerChunk> tileOffsets{};
+    std::array<int32_t, TerrainGen::tilesPerChunk> chunkTileBaseVertices;
+    bool tiledDraw = false;
+
+    // full resolution chunk, either as tiles plus seams or from the full index buffer
+    const auto drawHeightChunk = [&](int32_t chunkBaseVertex) {
+        if (tiledDraw) {
+            for (uint32_t t = 0; t < TerrainGen::tilesPerChunk; t++) {
+                chunkTileBaseVertices[t] = chunkBaseVertex + tileBaseVertices[t];
+            }
+            glBindVertexArray(tileVao);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, tileCounts.data(), GL_UNSIGNED_SHORT, tileOffsets.data(),
+                TerrainGen::tilesPerChunk, chunkTileBaseVertices.data());
+            glBindVertexArray(seamVao);
+            glDrawElementsBaseVertex(GL_TRIANGLES, seamIndices.size(), GL_UNSIGNED_INT, 0, chunkBaseVertex);
+        } else {
+            glBindVertexArray(vao);
+            glDrawElementsBaseVertex(GL_TRIANGLES, TerrainGen::elemCount, GL_UNSIGNED_INT, 0, chunkBaseVertex);
+        }
+    };
 
-    uint32_t skyboxTexture;
-    glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &skyboxTexture);
-    glTextureStorage2D(skyboxTexture, 1, GL_RGBA8, 512, 512);
+    // patches are generated from gl_VertexID, but core profile needs a vertex array bound for any draw
+    uint32_t emptyVao;
+    glCreateVertexArrays(1, &emptyVao);
 
-    glTextureParameteri(skyboxTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(skyboxTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(skyboxTexture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    // decoded on worker threads, the first frames render with placeholders
+    TextureLoader textureLoader;
+    // one layer per terrain material, sync with terrain.comp and shader.frag
+    const uint32_t materialTexture = textureLoader.loadArray(
+        {
+            "res/textures/grass3.jpg",
+            "res/textures/rock.jpg",
+            "res/textures/snow.jpg",
+            "res/textures/dirt.jpg",
+        },
+        true);
 
     const std::string skyboxPath = "res/textures/skybox/";
-    const std::vector<std::string> faces{
+    const uint32_t skyboxTexture = textureLoader.loadCube({
         skyboxPath + "px.png",
         skyboxPath + "nx.png",
         skyboxPath + "py.png",
         skyboxPath + "ny.png",
         skyboxPath + "pz.png",
         skyboxPath + "nz.png",
-    };
-
-    stbi_set_flip_vertically_on_load(false);
-    for (int face = 0; face < 6; ++face) {
-        int width, height, numChannels;
-        uint8_t* data = stbi_load(faces[face].c_str(), &width, &height, &numChannels, 0);
-        if (!data) {
-            throw std::runtime_error("could not load cubemap face " + faces[face]);
-        }
-
-        glTextureSubImage3D(skyboxTexture, 0, 0, 0, face, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
-    }
+    });
 
     // cube vertices
     const std::array skyboxVertices{-1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, -1.0f, -1.0f,
@@ -210,16 +356,67 @@ int main() {
     Camera cam(static_cast<float>(w) / static_cast<float>(h));
     cam.setPosition({200000.0f, 400.0f, 200000.0f});
 
-    const uint32_t modelLoc = glGetUniformLocation(program.handle(), "model");
-    const uint32_t viewLoc = glGetUniformLocation(program.handle(), "view");
-    const uint32_t projLoc = glGetUniformLocation(program.handle(), "proj");
-    const uint32_t camPosLoc = glGetUniformLocation(program.handle(), "camPos");
+    // the setup above overlapped with compiling, the window keeps handling events while the rest finishes
+    const std::array programs{&compProgram, &clipmapGenProgram, &horizonGenProgram, &program, &virtualProgram,
+        &depthProgram, &boundsProgram, &tessProgram, &virtualTessProgram, &virtualPageProgram, &rtinErrorProgram,
+        &ambientOcclusionProgram, &horizonProgram, &maxHeightProgram, &farFieldProgram, &clipmapProgram,
+        &skyboxProgram, &upscaleProgram};
+    while (!std::all_of(programs.begin(), programs.end(), [](const ShaderProgram* p) { return p->isReady(); })) {
+        glfwWaitEventsTimeout(0.001);
+    }
+    for (ShaderProgram* const p : programs) {
+        p->finish();
+    }
+    ShaderProgram::pruneBinaryCache();
+
+    // block bindings are hard coded in the shaders and where the buffers are bound, a mismatch would read the wrong
+    // buffer without any error
+    const auto checkBinding = [](const char* block, int32_t binding, uint32_t expected) {
+        if (binding != -1 && binding != static_cast<int32_t>(expected)) {
+            throw std::runtime_error(std::string(block) + " is at binding " + std::to_string(binding) + ", expected " +
+                                     std::to_string(expected));
+        }
+    };
+    for (const ShaderProgram* const p : programs) {
+        checkBinding("FrameBlock", p->uniformBlockBinding("FrameBlock"), frameDataBinding);
+        checkBinding("ssbo1", p->storageBlockBinding("ssbo1"), TerrainGen::vertexBinding);
+        checkBinding("errorBuffer", p->storageBlockBinding("errorBuffer"), Rtin::errorBinding);
+    }
 
-    const uint32_t powerLoc = glGetUniformLocation(program.handle(), "heightPower");
-    const uint32_t fogDistanceLoc = glGetUniformLocation(program.handle(), "fogDistance");
-    const uint32_t scaleLoc = glGetUniformLocation(program.handle(), "heightScale");
+    // uniforms set every frame or every chunk are looked up once, programs without one of them get -1
+    struct DrawUniforms {
+        int32_t model;
+        int32_t vertexLayout;
+        int32_t shadows;
+        int32_t lightViewProj;
+        int32_t chunkExtent;
+        int32_t patchesPerSide;
+        int32_t viewportHeight;
+        int32_t triangleSize;
+        int32_t maxTessLevel;
+        int32_t chunkOrigin;
+        int32_t layer;
+    };
+    const auto findDrawUniforms = [](const ShaderProgram& shader) {
+        return DrawUniforms{shader.findUniform("model"), shader.findUniform("vertexLayout"),
+            shader.findUniform("shadows"), shader.findUniform("lightViewProj"), shader.findUniform("chunkExtent"),
+            shader.findUniform("patchesPerSide"), shader.findUniform("viewportHeight"),
+            shader.findUniform("triangleSize"), shader.findUniform("maxTessLevel"), shader.findUniform("chunkOrigin"),
+            shader.findUniform("layer")};
+    };
+    const DrawUniforms depthUniforms = findDrawUniforms(depthProgram);
+    const DrawUniforms chunkUniforms = findDrawUniforms(program);
+    const DrawUniforms virtualChunkUniforms = findDrawUniforms(virtualProgram);
+    const DrawUniforms tessUniforms = findDrawUniforms(tessProgram);
+    const DrawUniforms virtualTessUniforms = findDrawUniforms(virtualTessProgram);
+    const int32_t farFieldInvViewProjUniform = farFieldProgram.findUniform("invViewProj");
+    const int32_t farFieldSpacingUniform = farFieldProgram.findUniform("sampleSpacing");
+    const int32_t horizonCenterUniform = horizonProgram.findUniform("residentCenter");
+    const int32_t horizonDistanceUniform = horizonProgram.findUniform("residentDistance");
+    terrainGen.findUniforms(compProgram);
 
     glEnable(GL_DEPTH_TEST);
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
 
     const auto processMouse = [&cam, &input]() {
         static double lastXPos = 0;
@@ -276,6 +473,76 @@ int main() {
     };
 
     const uint32_t chunkCount = terrainGen.getChunkCount();
+    OcclusionCuller occlusionCuller(chunkCount);
+    std::vector<Aabb> chunkBounds(chunkCount);
+    bool occlusionCulling = false;
+
+    std::vector<uint32_t> drawOrder(chunkCount);
+    std::vector<float> chunkDistances(chunkCount);
+    bool depthPrepass = false;
+
+    TerrainMode terrainMode = TerrainMode::Indexed;
+    constexpr uint32_t tessPatchesPerSide = 32;
+    constexpr float maxTessLevel = static_cast<float>(TerrainGen::chunkSize - 1) / tessPatchesPerSide;
+    float tessTriangleSize = 8.0f;
+
+    Clipmap clipmap;
+
+    // adaptive meshes for chunks further away than a chunk, the ones close by keep the full grid
+    Rtin rtin(chunkCount);
+    bool rtinFarChunks = false;
+    float rtinPixelError = 1.0f;
+    uint32_t rtinTriangles = 0;
+
+    // the chunk vertices cast the shadows, so they are only available in the chunk based modes
+    ShadowCascades shadowCascades(chunkCount);
+    bool sunShadows = false;
+
+    AmbientOcclusion ambientOcclusion;
+    bool bakeAmbientOcclusion = false;
+
+    // coarse terrain out to 10 times the streamed range, fog distance has to be raised to see it
+    HorizonRing horizonRing;
+    bool drawHorizon = false;
+
+    // resident chunks further away than farFieldStart chunks can be ray marched instead of rasterized
+    FarField farField(chunkCount);
+    bool rayMarchFarField = false;
+    float farFieldStart = 2.0f;
+    std::vector<FarChunk> farChunks;
+
+    // materials baked into pages on demand instead of blended per fragment, chunk based modes only
+    VirtualTexture virtualTexture(chunkCount);
+    bool virtualTexturing = false;
+
+    const uint32_t rtinVao = createChunkVao(rtin.getIndexBuffer());
+
+    GpuTimer genTimer;
+    GpuTimer terrainTimer;
+
+    // the scene is rendered at a resolution that keeps its gpu time in budget and upscaled, the gui is drawn after
+    DynamicResolution dynamicResolution;
+    ResolutionConfig resolutionConfig;
+
+    // only redraws after a change, then for a few frames while culling results, streaming and the gui settle
+    constexpr uint32_t settleFrames = 4;
+    constexpr double idleTimeout = 0.25;
+    bool renderOnDemand = false;
+    uint32_t redrawFrames = 0;
+    glm::mat4 drawnView(0.0f);
+    glm::uvec2 drawnSize(0);
+
+    // how many frames the cpu may record ahead of the gpu, per frame data is written into the region of the frame
+    FrameSync frameSync;
+    int32_t framesInFlight = static_cast<int32_t>(frameSync.getFramesInFlight());
+
+    // caps the frame rate below the refresh rate when set, and measures the pacing in every present mode
+    FrameLimiter frameLimiter;
+    float fpsLimit = 0.0f;
+
+    // camera and terrain settings shared by every program, written once per frame
+    UniformRing uniformRing(frameSync, 64 * 1024);
+    FrameData frameData{};
 
     double lastTime = 0;
 
@@ -286,8 +553,6 @@ int main() {
     glfwSetInputMode(window.handle(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     while (!glfwWindowShouldClose(window.handle())) {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
         {
             const double time = glfwGetTime();
             const double dt = time - lastTime;
@@ -299,6 +564,29 @@ int main() {
             cam.update();
         }
 
+        const auto [windowWidth, windowHeight] = window.size();
+        const glm::uvec2 windowSize(windowWidth, windowHeight);
+        if (window.takeEvents() || cam.getView() != drawnView || windowSize != drawnSize) {
+            redrawFrames = settleFrames;
+        }
+        if (renderOnDemand && redrawFrames == 0) {
+            // the last presented frame stays on screen, an event or the timeout wakes the loop up again
+            glfwWaitEventsTimeout(idleTimeout);
+            lastTime = glfwGetTime(); // time spent waiting is not time spent moving
+            frameLimiter.reset();
+            continue;
+        }
+        redrawFrames = redrawFrames > 0 ? redrawFrames - 1 : 0;
+        drawnView = cam.getView();
+        drawnSize = windowSize;
+
+        frameSync.beginFrame();
+
+        dynamicResolution.setConfig(resolutionConfig);
+        dynamicResolution.begin(windowSize);
+        const glm::uvec2 renderSize = dynamicResolution.getRenderSize();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
         Gui::startFrame();
 
         const auto camPos = cam.getPosition();
@@ -315,6 +603,108 @@ int main() {
             ImGui::DragFloat("scale", &heightScale);
             ImGui::DragFloat("power", &heightPower, 0.1f, 0.5f, 10.0f);
             ImGui::DragFloat2("fog distance (min/max)", glm::value_ptr(fogDistance), 20.0f);
+            if (ImGui::Checkbox("occlusion queries", &occlusionCulling) && !occlusionCulling) {
+                occlusionCuller.invalidateAll();
+            }
+            if (occlusionCulling) {
+                ImGui::Text("occluded chunks: %u / %u", occlusionCuller.getSkippedCount(), chunkCount);
+            }
+            const char* const terrainModes[] = {"indexed", "tessellation", "clipmap"};
+            ImGui::Combo("renderer", reinterpret_cast<int*>(&terrainMode), terrainModes, 3);
+            if (terrainMode == TerrainMode::Tessellation) {
+                ImGui::SliderFloat("triangle size (px)", &tessTriangleSize, 1.0f, 64.0f);
+            }
+            if (terrainMode == TerrainMode::Clipmap) {
+                ImGui::Text("clipmap triangles: %u", clipmap.getTriangleCount());
+            }
+            ImGui::Checkbox("depth prepass", &depthPrepass);
+            if (ImGui::Checkbox("sun shadows", &sunShadows) && sunShadows) {
+                shadowCascades.invalidate();
+            }
+            if (sunShadows) {
+                ImGui::Text("shadow chunk draws: %u", shadowCascades.getDrawCount());
+            }
+            if (ImGui::Checkbox("baked ambient occlusion", &bakeAmbientOcclusion)) {
+                if (bakeAmbientOcclusion) {
+                    ambientOcclusion.invalidateAll(terrainGen);
+                } else {
+                    // regenerating is the only way to clear what is already baked
+                    ambientOcclusion.clear();
+                    terrainGen.clearChunkCache();
+                }
+            }
+            if (bakeAmbientOcclusion) {
+                ImGui::Text("queued occlusion regions: %zu", ambientOcclusion.getQueuedCount());
+            }
+            ImGui::Checkbox("horizon ring", &drawHorizon);
+            if (drawHorizon) {
+                ImGui::Text("horizon triangles: %u", horizonRing.getTriangleCount());
+            }
+            ImGui::Checkbox("ray marched far field", &rayMarchFarField);
+            if (rayMarchFarField) {
+                ImGui::SliderFloat("ray march beyond (chunks)", &farFieldStart, 0.5f, TerrainGen::chunkDistance);
+            }
+            ImGui::Checkbox("virtual texturing", &virtualTexturing);
+            if (virtualTexturing) {
+                ImGui::Text("resident pages: %u, baked: %u", virtualTexture.getResidentCount(),
+                    virtualTexture.getBakedCount());
+            }
+            const char* const presentModes[] = {"vsync", "adaptive vsync", "uncapped"};
+            int presentMode = static_cast<int>(window.getPresentMode());
+            if (ImGui::Combo("present mode", &presentMode, presentModes, 3) &&
+                !window.setPresentMode(static_cast<PresentMode>(presentMode))) {
+                std::cerr << "ERROR: adaptive vsync is not supported, using vsync" << std::endl;
+            }
+            if (ImGui::SliderFloat("fps limit (0 = off)", &fpsLimit, 0.0f, 240.0f, "%.0f")) {
+                frameLimiter.setTargetFps(fpsLimit);
+            }
+            ImGui::Text("frame: %.2f ms, jitter: %.2f ms, max: %.2f ms", frameLimiter.getAverageMilliseconds(),
+                frameLimiter.getJitterMilliseconds(), frameLimiter.getMaxMilliseconds());
+            const int32_t frameCount = static_cast<int32_t>(frameSync.getFrameCount());
+            if (ImGui::SliderInt("frames in flight", &framesInFlight, 1, frameCount)) {
+                frameSync.setFramesInFlight(framesInFlight);
+            }
+            ImGui::Text("cpu wait for gpu: %.2f ms", frameSync.getAverageWaitMilliseconds());
+            ImGui::Checkbox("render on demand", &renderOnDemand);
+            ImGui::Checkbox("dynamic resolution", &resolutionConfig.enabled);
+            if (resolutionConfig.enabled) {
+                ImGui::SliderFloat("scene budget (ms)", &resolutionConfig.budgetMs, 2.0f, 50.0f);
+                ImGui::SliderFloat("min scale", &resolutionConfig.minScale, 0.25f, resolutionConfig.maxScale);
+            }
+            ImGui::SliderFloat("max scale", &resolutionConfig.maxScale, resolutionConfig.minScale, 1.5f);
+            ImGui::Text("render size: %ux%u (%.0f%%), scene: %.2f ms", renderSize.x, renderSize.y,
+                dynamicResolution.getScale() * 100.0f, dynamicResolution.getSceneMilliseconds());
+            ImGui::Checkbox("rtin far chunks", &rtinFarChunks);
+            if (rtinFarChunks) {
+                ImGui::SliderFloat("rtin error (px)", &rtinPixelError, 0.25f, 16.0f);
+                ImGui::Text("rtin triangles: %u", rtinTriangles);
+            }
+
+            const char* const indexOrders[] = {"row major", "strips"};
+            const char* const vertexLayouts[] = {"row major", "morton"};
+            const bool orderChanged = ImGui::Combo("index order", reinterpret_cast<int*>(&indexOrder), indexOrders, 2);
+            bool layoutChanged = ImGui::Combo("vertex layout", reinterpret_cast<int*>(&vertexLayout), vertexLayouts, 2);
+            if (ImGui::Checkbox("16 bit tiles (morton only)", &tiledDraw) && tiledDraw &&
+                vertexLayout != VertexLayout::Morton) {
+                vertexLayout = VertexLayout::Morton;
+                layoutChanged = true;
+            }
+            if (layoutChanged) {
+                tiledDraw = tiledDraw && vertexLayout == VertexLayout::Morton;
+                terrainGen.setVertexLayout(vertexLayout);
+            }
+            if (tiledDraw && ebo != 0) {
+                freeHeightIndices();
+            } else if (!tiledDraw && (ebo == 0 || orderChanged || layoutChanged)) {
+                uploadHeightIndices();
+            }
+            if (orderChanged) {
+                const auto newTileIndices = TerrainGen::genTileIndices(indexOrder);
+                glNamedBufferSubData(tileEbo, 0, newTileIndices.size() * sizeof(uint16_t), newTileIndices.data());
+            }
+            ImGui::Text("terrain draw: %.2f ms", terrainTimer.getAverageMilliseconds());
+            ImGui::Text("last chunk generation: %.2f ms", genTimer.getMilliseconds());
+            ImGui::Text("images loading: %u", textureLoader.getPendingCount());
 
             ImGui::SeparatorText("Generation settings");
             if (ImGui::Button("reset")) {
@@ -329,52 +719,275 @@ int main() {
             if (ImGui::Button("generate")) {
                 terrainGen.clearChunkCache();
                 terrainGen.setConfig(genConfig);
-                terrainGen.update(compProgram, vbo, chunkPos);
+                clipmap.invalidate();
+                horizonRing.invalidate();
             }
             ImGui::End();
         }
 
-        terrainGen.update(compProgram, vbo, chunkPos);
-
-        program.bind();
-        glUniform1f(scaleLoc, heightScale);
-        glUniform1f(powerLoc, heightPower);
-        glUniform2f(fogDistanceLoc, fogDistance.x, fogDistance.y);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(cam.getView()));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(cam.getProj()));
-        glUniform3fv(camPosLoc, 1, glm::value_ptr(cam.getPosition()));
-        glBindTextureUnit(0, rockTexture);
-        glBindTextureUnit(1, grassTexture);
-        glBindVertexArray(vao);
+        textureLoader.update();
+        uniformRing.beginFrame();
+        frameData.view = cam.getView();
+        frameData.proj = cam.getProj();
+        frameData.viewProj = frameData.proj * frameData.view;
+        frameData.camPos = cam.getPosition();
+        frameData.heightScale = heightScale;
+        frameData.fogDistance = fogDistance;
+        frameData.heightPower = heightPower;
+        const size_t frameDataOffset = uniformRing.push(frameData);
+        const auto bindFrameData = [&]() { uniformRing.bind(frameDataBinding, frameDataOffset, sizeof(FrameData)); };
+        bindFrameData();
+
+        // the clipmap generates its own terrain, chunks are only streamed in the chunk based modes
+        const bool chunked = terrainMode != TerrainMode::Clipmap;
+        genTimer.begin();
+        std::vector<uint32_t> generatedSlots;
+        if (chunked) {
+            generatedSlots = terrainGen.update(compProgram, vbo, heightMap, splatMap, chunkPos);
+        } else {
+            clipmap.update(clipmapGenProgram, terrainGen.getConfig(), camPos);
+        }
+        if (chunked && generatedSlots.empty()) {
+            genTimer.discard();
+        } else {
+            genTimer.end();
+        }
+        if (chunked && bakeAmbientOcclusion) {
+            ambientOcclusion.invalidate(terrainGen, generatedSlots);
+            ambientOcclusion.update(ambientOcclusionProgram, terrainGen, vbo, heightMap, vertexLayout);
+        }
+        const bool drawShadows = chunked && sunShadows;
+        if (drawShadows) {
+            shadowCascades.update(
+                depthProgram, uniformRing, frameData, terrainGen, generatedSlots, [&](uint32_t slot) {
+                    drawHeightChunk(TerrainGen::chunkSize * TerrainGen::chunkSize * slot);
+                });
+            bindFrameData();
+        }
+        const auto setShadowUniforms = [&](const ShaderProgram& shader, const DrawUniforms& uniforms) {
+            shader.set(uniforms.shadows, static_cast<int32_t>(drawShadows));
+            shader.set(uniforms.lightViewProj, shadowCascades.getViewProjs().data(), ShadowCascades::cascadeCount);
+            glBindTextureUnit(6, shadowCascades.getTexture());
+        };
+
+        if (chunked && drawHorizon) {
+            horizonRing.update(horizonGenProgram, terrainGen.getConfig(), camPos);
+        }
+        occlusionCuller.invalidate(generatedSlots);
+        rtin.invalidate(generatedSlots);
+        farField.update(maxHeightProgram, heightMap, generatedSlots);
+        virtualTexture.invalidate(generatedSlots);
+        const bool useVirtualTexture = virtualTexturing && chunked;
+        if (useVirtualTexture) {
+            virtualTexture.update(virtualPageProgram, terrainGen, splatMap, textureLoader.get(materialTexture));
+        }
+
+        // front to back, so early depth testing rejects as much hidden terrain as possible
         for (uint32_t i = 0; i < chunkCount; i++) {
-            glDrawElementsBaseVertex(GL_TRIANGLES, TerrainGen::elemCount, GL_UNSIGNED_INT, 0,
-                TerrainGen::chunkSize * TerrainGen::chunkSize * i);
+            const ChunkBounds bounds = terrainGen.getChunkBounds(i);
+            const glm::vec2 camXZ(camPos.x, camPos.z);
+            chunkDistances[i] = glm::distance(camXZ, glm::clamp(camXZ, bounds.min, bounds.max));
+        }
+        std::iota(drawOrder.begin(), drawOrder.end(), 0);
+        std::sort(drawOrder.begin(), drawOrder.end(),
+            [&](uint32_t a, uint32_t b) { return chunkDistances[a] < chunkDistances[b]; });
+
+        const bool useFarField = rayMarchFarField && terrainMode == TerrainMode::Indexed;
+        const auto isFarFieldChunk = [&](uint32_t slot) {
+            return useFarField && chunkDistances[slot] > farFieldStart * TerrainGen::chunkSize;
+        };
+
+        const bool useRtin = rtinFarChunks && terrainMode == TerrainMode::Indexed;
+        const auto isRtinChunk = [&](uint32_t slot) {
+            return useRtin && chunkDistances[slot] > TerrainGen::chunkSize && rtin.isReady(slot);
+        };
+        if (useRtin) {
+            // screen space error to height map units at the closest point of every chunk. the power only ever makes
+            // differences in height smaller, so dividing by it would allow too much error
+            const float pixelsPerUnit = cam.getProj()[1][1] * renderSize.y * 0.5f;
+            const float heightUnits = heightScale * std::max(heightPower, 1.0f);
+            for (uint32_t i = 0; i < chunkCount; i++) {
+                if (chunkDistances[i] > TerrainGen::chunkSize && !isFarFieldChunk(i)) {
+                    rtin.setMaxError(i, rtinPixelError * chunkDistances[i] / (pixelsPerUnit * heightUnits));
+                }
+            }
+            rtin.update(rtinErrorProgram, heightMap, vertexLayout);
+        }
+
+        rtinTriangles = 0;
+        for (uint32_t i = 0; i < chunkCount; i++) {
+            rtinTriangles += isRtinChunk(i) && !isFarFieldChunk(i) ? rtin.getIndexCount(i) / 3 : 0;
+        }
+
+        const auto setVertexUniforms = [&](const ShaderProgram& shader, const DrawUniforms& uniforms) {
+            shader.set(uniforms.model, model);
+            shader.set(uniforms.vertexLayout, static_cast<uint32_t>(vertexLayout));
+        };
+
+        const auto drawChunks = [&]() {
+            for (const uint32_t i : drawOrder) {
+                if (isFarFieldChunk(i)) {
+                    continue;
+                }
+                if (occlusionCulling) {
+                    occlusionCuller.beginChunk(i);
+                }
+
+                const int32_t chunkBaseVertex = TerrainGen::chunkSize * TerrainGen::chunkSize * i;
+                if (isRtinChunk(i)) {
+                    glBindVertexArray(rtinVao);
+                    glDrawElementsBaseVertex(GL_TRIANGLES, rtin.getIndexCount(i), GL_UNSIGNED_INT,
+                        reinterpret_cast<const void*>(rtin.getIndexOffset(i)), chunkBaseVertex);
+                } else {
+                    drawHeightChunk(chunkBaseVertex);
+                }
+
+                if (occlusionCulling) {
+                    occlusionCuller.endChunk(i);
+                }
+            }
+        };
+
+        // every terrain mode shades from the material layers and their weights
+        glBindTextureUnit(0, textureLoader.get(materialTexture));
+        glBindTextureUnit(7, splatMap);
+        dynamicResolution.beginScene();
+        terrainTimer.begin();
+        if (terrainMode == TerrainMode::Indexed) {
+            if (depthPrepass) {
+                depthProgram.bind();
+                setVertexUniforms(depthProgram, depthUniforms);
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                drawChunks();
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+                // only the visible surface is shaded
+                glDepthFunc(GL_EQUAL);
+                glDepthMask(GL_FALSE);
+            }
+
+            const ShaderProgram& chunkProgram = useVirtualTexture ? virtualProgram : program;
+            const DrawUniforms& uniforms = useVirtualTexture ? virtualChunkUniforms : chunkUniforms;
+            chunkProgram.bind();
+            setVertexUniforms(chunkProgram, uniforms);
+            setShadowUniforms(chunkProgram, uniforms);
+            if (useVirtualTexture) {
+                virtualTexture.bind(chunkProgram, glm::ivec2(renderSize));
+            }
+            drawChunks();
+
+            if (depthPrepass) {
+                glDepthMask(GL_TRUE);
+                glDepthFunc(GL_LESS);
+            }
+
+            if (useFarField) {
+                farChunks.clear();
+                for (const uint32_t i : drawOrder) {
+                    if (isFarFieldChunk(i)) {
+                        farChunks.push_back({terrainGen.getChunkBounds(i).min, chunkDistances[i], i});
+                    }
+                }
+
+                farFieldProgram.bind();
+                farFieldProgram.set(farFieldInvViewProjUniform, glm::inverse(frameData.viewProj));
+                farFieldProgram.set(farFieldSpacingUniform, TerrainGen::sampleSpacing);
+                farField.draw(farFieldProgram, heightMap, farChunks);
+            }
+        } else if (terrainMode == TerrainMode::Tessellation) {
+            const ShaderProgram& tessShader = useVirtualTexture ? virtualTessProgram : tessProgram;
+            const DrawUniforms& uniforms = useVirtualTexture ? virtualTessUniforms : tessUniforms;
+            tessShader.bind();
+            tessShader.set(uniforms.chunkExtent, (TerrainGen::chunkSize - 1) * TerrainGen::sampleSpacing);
+            tessShader.set(uniforms.patchesPerSide, tessPatchesPerSide);
+            tessShader.set(uniforms.viewportHeight, static_cast<float>(renderSize.y));
+            tessShader.set(uniforms.triangleSize, tessTriangleSize);
+            tessShader.set(uniforms.maxTessLevel, maxTessLevel);
+            setShadowUniforms(tessShader, uniforms);
+            if (useVirtualTexture) {
+                virtualTexture.bind(tessShader, glm::ivec2(renderSize));
+            }
+            glBindTextureUnit(2, heightMap);
+            glBindVertexArray(emptyVao);
+
+            for (const uint32_t i : drawOrder) {
+                if (occlusionCulling) {
+                    occlusionCuller.beginChunk(i);
+                }
+
+                const ChunkBounds bounds = terrainGen.getChunkBounds(i);
+                tessShader.set(uniforms.chunkOrigin, bounds.min);
+                tessShader.set(uniforms.layer, i);
+                glDrawArrays(GL_PATCHES, 0, tessPatchesPerSide * tessPatchesPerSide * 4);
+
+                if (occlusionCulling) {
+                    occlusionCuller.endChunk(i);
+                }
+            }
+        } else {
+            clipmapProgram.bind();
+            clipmap.draw(clipmapProgram);
+        }
+
+        if (chunked && drawHorizon) {
+            horizonProgram.bind();
+            horizonProgram.set(horizonCenterUniform, chunkPos);
+            horizonProgram.set(horizonDistanceUniform, static_cast<int32_t>(TerrainGen::chunkDistance));
+            horizonRing.draw(horizonProgram);
+        }
+        terrainTimer.end();
+        if (useVirtualTexture) {
+            virtualTexture.endFrame();
+        }
+
+        if (occlusionCulling && chunked) {
+            const float minHeight = std::min(0.0f, heightScale);
+            const float maxHeight = std::max(0.0f, heightScale);
+            for (uint32_t i = 0; i < chunkCount; i++) {
+                const ChunkBounds bounds = terrainGen.getChunkBounds(i);
+                chunkBounds[i] = Aabb{glm::vec3(bounds.min.x, minHeight, bounds.min.y),
+                    glm::vec3(bounds.max.x, maxHeight, bounds.max.y)};
+            }
+            occlusionCuller.queryBounds(boundsProgram, frameData.viewProj, chunkBounds, camPos);
         }
 
         glDepthFunc(GL_LEQUAL);
         skyboxProgram.bind();
-        const glm::mat4 view2 = glm::mat4(glm::mat3(cam.getView()));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view2));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(cam.getProj()));
-        glBindTextureUnit(1, skyboxTexture);
+        glBindTextureUnit(1, textureLoader.get(skyboxTexture));
         glBindVertexArray(skyboxVao);
         glDrawArrays(GL_TRIANGLES, 0, skyboxVertices.size());
         glDepthFunc(GL_LESS);
 
+        dynamicResolution.upscale(upscaleProgram);
         Gui::endFrame();
 
+        // work that is spread over frames keeps the loop drawing until it is done
+        const bool busy = !generatedSlots.empty() || textureLoader.getPendingCount() > 0 ||
+                          (useRtin && rtin.isBuilding()) ||
+                          (chunked && bakeAmbientOcclusion && ambientOcclusion.getQueuedCount() > 0) ||
+                          (useVirtualTexture && virtualTexture.getBakedCount() > 0);
+        if (busy) {
+            redrawFrames = settleFrames;
+        }
+
+        frameSync.endFrame();
         glfwSwapBuffers(window.handle());
+        frameLimiter.wait();
         glfwPollEvents();
     }
 
     Gui::shutdown();
 
-    glDeleteTextures(1, &rockTexture);
-    glDeleteTextures(1, &grassTexture);
+    glDeleteTextures(1, &heightMap);
+    glDeleteTextures(1, &splatMap);
     glDeleteVertexArrays(1, &skyboxVao);
-    glDeleteVertexArrays(1, &vao);
+    glDeleteVertexArrays(1, &tileVao);
+    glDeleteVertexArrays(1, &seamVao);
+    glDeleteVertexArrays(1, &rtinVao);
+    glDeleteVertexArrays(1, &emptyVao);
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &skyboxVbo);
-    glDeleteBuffers(1, &ebo);
+    freeHeightIndices();
+    glDeleteBuffers(1, &tileEbo);
+    glDeleteBuffers(1, &seamEbo);
 }
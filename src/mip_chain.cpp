@@ -0,0 +1,58 @@
+#include "mip_chain.h"
+#include <algorithm>
+#include <cstring>
+
+uint32_t mipLevelCount(int32_t width, int32_t height) {
+    uint32_t levels = 1;
+    while ((std::max(width, height) >> levels) > 0) {
+        levels++;
+    }
+    return levels;
+}
+
+size_t mipLevelOffset(int32_t width, int32_t height, uint32_t level, uint32_t bytesPerPixel) {
+    size_t offset = 0;
+    for (uint32_t i = 0; i < level; i++) {
+        offset += size_t(std::max(width >> i, 1)) * std::max(height >> i, 1) * bytesPerPixel;
+    }
+    return offset;
+}
+
+std::vector<uint8_t> buildMipChain(const uint8_t* pixels, int32_t width, int32_t height, uint32_t levels) {
+    std::vector<uint8_t> chain(mipLevelOffset(width, height, levels));
+    std::memcpy(chain.data(), pixels, size_t(width) * height * 4);
+
+    // a box filter over the 2x2 texels under each texel. for odd sizes the last texel also takes in the extra row or
+    // column, so nothing is dropped
+    const auto footprintEnd = [](int32_t dst, int32_t dstSize, int32_t srcSize) {
+        const bool oddEdge = dst == dstSize - 1 && srcSize > 1 && srcSize % 2 == 1;
+        return oddEdge ? dst * 2 + 2 : std::min(dst * 2 + 1, srcSize - 1);
+    };
+    uint8_t* src = chain.data();
+    for (uint32_t level = 1; level < levels; level++) {
+        const int32_t srcWidth = std::max(width >> (level - 1), 1);
+        const int32_t srcHeight = std::max(height >> (level - 1), 1);
+        const int32_t dstWidth = std::max(width >> level, 1);
+        const int32_t dstHeight = std::max(height >> level, 1);
+        uint8_t* dst = src + size_t(srcWidth) * srcHeight * 4;
+
+        for (int32_t y = 0; y < dstHeight; y++) {
+            const int32_t y1 = footprintEnd(y, dstHeight, srcHeight);
+            for (int32_t x = 0; x < dstWidth; x++) {
+                const int32_t x1 = footprintEnd(x, dstWidth, srcWidth);
+                const uint32_t count = (x1 - x * 2 + 1) * (y1 - y * 2 + 1);
+                for (int32_t c = 0; c < 4; c++) {
+                    uint32_t sum = 0;
+                    for (int32_t sy = y * 2; sy <= y1; sy++) {
+                        for (int32_t sx = x * 2; sx <= x1; sx++) {
+                            sum += src[(sy * srcWidth + sx) * 4 + c];
+                        }
+                    }
+                    dst[(y * dstWidth + x) * 4 + c] = (sum + count / 2) / count;
+                }
+            }
+        }
+        src = dst;
+    }
+    return chain;
+}
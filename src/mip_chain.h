@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// levels down to 1x1
+uint32_t mipLevelCount(int32_t width, int32_t height);
+size_t mipLevelOffset(int32_t width, int32_t height, uint32_t level, uint32_t bytesPerPixel = 4);
+
+// rgba8 pixels of every level after each other, each level is a 2x2 box filter of the previous one
+std::vector<uint8_t> buildMipChain(const uint8_t* pixels, int32_t width, int32_t height, uint32_t levels);
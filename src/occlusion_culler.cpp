@@ -0,0 +1,116 @@
+#include "occlusion_culler.h"
+#include <algorithm>
+#include <array>
+#include <glad/gl.h>
+
+// unit cube, scaled to the box in the vertex shader
+static constexpr std::array boxVertices{
+    0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // back
+    0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f, // front
+};
+
+static constexpr std::array<uint8_t, 36> boxIndices{
+    0, 1, 2, 2, 3, 0, // back
+    4, 5, 6, 6, 7, 4, // front
+    0, 4, 7, 7, 3, 0, // left
+    1, 5, 6, 6, 2, 1, // right
+    3, 2, 6, 6, 7, 3, // top
+    0, 1, 5, 5, 4, 0, // bottom
+};
+
+// camera inside a box (or close enough for the near plane to clip it) would make the query fail
+static constexpr float insideMargin = 1.0f;
+
+OcclusionCuller::OcclusionCuller(uint32_t chunkCount) : queries(chunkCount), hasResult(chunkCount, false) {
+    glCreateQueries(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, chunkCount, queries.data());
+
+    glCreateBuffers(1, &vbo);
+    glNamedBufferStorage(vbo, sizeof(boxVertices), boxVertices.data(), 0);
+    glCreateBuffers(1, &ebo);
+    glNamedBufferStorage(ebo, sizeof(boxIndices), boxIndices.data(), 0);
+
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(float) * 3);
+    glVertexArrayElementBuffer(vao, ebo);
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    glDeleteQueries(queries.size(), queries.data());
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+}
+
+void OcclusionCuller::invalidate(const std::vector<uint32_t>& slots) {
+    for (const uint32_t slot : slots) {
+        hasResult[slot] = false;
+    }
+}
+
+void OcclusionCuller::invalidateAll() {
+    std::fill(hasResult.begin(), hasResult.end(), false);
+    skippedCount = 0;
+}
+
+void OcclusionCuller::beginChunk(uint32_t slot) const {
+    if (hasResult[slot]) {
+        glBeginConditionalRender(queries[slot], GL_QUERY_NO_WAIT);
+    }
+}
+
+void OcclusionCuller::endChunk(uint32_t slot) const {
+    if (hasResult[slot]) {
+        glEndConditionalRender();
+    }
+}
+
+void OcclusionCuller::queryBounds(
+    const ShaderProgram& boundsShader, const glm::mat4& viewProj, const std::vector<Aabb>& bounds, glm::vec3 camPos) {
+
+    // count results of last frame before the queries are reissued. never wait on the gpu for this
+    skippedCount = 0;
+    for (uint32_t i = 0; i < queries.size(); i++) {
+        if (!hasResult[i]) {
+            continue;
+        }
+
+        uint32_t available = GL_FALSE;
+        glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            uint32_t passed = GL_TRUE;
+            glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &passed);
+            skippedCount += passed ? 0 : 1;
+        }
+    }
+
+    boundsShader.bind();
+    boundsShader.set("viewProj", viewProj);
+    const int32_t boxMinUniform = boundsShader.findUniform("boxMin");
+    const int32_t boxMaxUniform = boundsShader.findUniform("boxMax");
+    glBindVertexArray(vao);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+
+    for (uint32_t i = 0; i < bounds.size(); i++) {
+        const Aabb& box = bounds[i];
+        const bool inside = glm::all(glm::greaterThanEqual(camPos, box.min - insideMargin)) &&
+                            glm::all(glm::lessThanEqual(camPos, box.max + insideMargin));
+        if (inside) {
+            hasResult[i] = false;
+            continue;
+        }
+
+        boundsShader.set(boxMinUniform, box.min);
+        boundsShader.set(boxMaxUniform, box.max);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, queries[i]);
+        glDrawElements(GL_TRIANGLES, boxIndices.size(), GL_UNSIGNED_BYTE, nullptr);
+        glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+        hasResult[i] = true;
+    }
+
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
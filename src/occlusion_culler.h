@@ -0,0 +1,47 @@
+#pragma once
+#include "shader_program.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+struct Aabb {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Hardware occlusion culling for chunks. Every frame the bounding box of each chunk is rasterized against the depth
+// buffer with a conservative any samples passed query, and the next frame draws the chunk inside a conditional render
+// block using that result. Results lag one frame, so a chunk can pop in a frame late when it becomes visible.
+class OcclusionCuller {
+public:
+    OcclusionCuller(uint32_t chunkCount);
+
+    OcclusionCuller(const OcclusionCuller& other) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller& other) = delete;
+
+    ~OcclusionCuller();
+
+    // forget query results of slots that now hold different chunks
+    void invalidate(const std::vector<uint32_t>& slots);
+    void invalidateAll();
+
+    // wrap a draw of the chunk in slot with a conditional render block using the last query result
+    void beginChunk(uint32_t slot) const;
+    void endChunk(uint32_t slot) const;
+
+    // rasterize the bounds of every chunk against the current depth buffer. call after all occluders are drawn
+    void queryBounds(const ShaderProgram& boundsShader, const glm::mat4& viewProj, const std::vector<Aabb>& bounds,
+        glm::vec3 camPos);
+
+    // number of chunks that were occluded in the last frame with an available query result
+    uint32_t getSkippedCount() const { return skippedCount; }
+
+private:
+    std::vector<uint32_t> queries;
+    std::vector<bool> hasResult;
+    uint32_t skippedCount = 0;
+
+    uint32_t vao;
+    uint32_t vbo;
+    uint32_t ebo;
+};
@@ -0,0 +1,161 @@
+#include "rtin.h"
+#include <cmath>
+#include <cstring>
+#include <glad/gl.h>
+
+Rtin::Rtin(uint32_t chunkCount) : slots(chunkCount), errors(gridSize * gridSize) {
+    indices.reserve(maxTriangles * 3);
+
+    glCreateBuffers(1, &errorBuffer);
+    glNamedBufferStorage(errorBuffer, gridSize * gridSize * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateBuffers(1, &ebo);
+    glNamedBufferStorage(ebo, chunkCount * maxTriangles * 3 * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+Rtin::~Rtin() {
+    if (fence) {
+        glDeleteSync(fence);
+    }
+    glDeleteBuffers(1, &errorBuffer);
+    glDeleteBuffers(1, &ebo);
+}
+
+void Rtin::queue(uint32_t slot) {
+    if (!slots[slot].queued) {
+        slots[slot].queued = true;
+        buildQueue.push_back(slot);
+    }
+}
+
+void Rtin::invalidate(const std::vector<uint32_t>& invalidSlots) {
+    for (const uint32_t slot : invalidSlots) {
+        slots[slot].ready = false;
+        slots[slot].version++;
+        if (slots[slot].maxError > 0.0f) {
+            queue(slot);
+        }
+    }
+}
+
+void Rtin::setMaxError(uint32_t slot, float maxError) {
+    const float budget = std::exp2(std::floor(std::log2(std::max(maxError, 1e-6f))));
+    if (budget == slots[slot].maxError) {
+        return;
+    }
+
+    // the old mesh stays in use until the new one is done
+    slots[slot].maxError = budget;
+    queue(slot);
+}
+
+void Rtin::update(const ShaderProgram& errorShader, uint32_t heightMapId, VertexLayout layout) {
+    if (building != noSlot) {
+        const GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return;
+        }
+        finishBuild(layout);
+    }
+
+    if (!buildQueue.empty()) {
+        const uint32_t slot = buildQueue.front();
+        buildQueue.pop_front();
+        slots[slot].queued = false;
+        startBuild(errorShader, heightMapId, slot);
+    }
+}
+
+void Rtin::startBuild(const ShaderProgram& errorShader, uint32_t heightMapId, uint32_t slot) {
+    building = slot;
+    buildingVersion = slots[slot].version;
+    buildingError = slots[slot].maxError;
+
+    const uint32_t zero = 0;
+    glClearNamedBufferData(errorBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    errorShader.bind();
+    errorShader.set("layer", slot);
+    errorShader.set("refineBorders", 1);
+    glBindTextureUnit(2, heightMapId);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, errorBinding, errorBuffer);
+
+    // smallest triangles first, every level reads the errors of the one below it
+    const int32_t levelStartUniform = errorShader.findUniform("levelStart");
+    const int32_t levelSizeUniform = errorShader.findUniform("levelSize");
+    const int32_t leafLevelUniform = errorShader.findUniform("leafLevel");
+    for (uint32_t level = levelCount; level >= 1; level--) {
+        const uint32_t levelSize = 1u << level;
+        errorShader.set(levelStartUniform, levelSize);
+        errorShader.set(levelSizeUniform, levelSize);
+        errorShader.set(leafLevelUniform, static_cast<int32_t>(level == levelCount));
+        glDispatchCompute((levelSize + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void Rtin::finishBuild(VertexLayout layout) {
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    const uint32_t slot = building;
+    building = noSlot;
+
+    // chunk was replaced while its error map was built
+    if (slots[slot].version != buildingVersion) {
+        return;
+    }
+
+    glGetNamedBufferSubData(errorBuffer, 0, errors.size() * sizeof(uint32_t), errors.data());
+    if (!extract(buildingError, layout)) {
+        slots[slot].ready = false;
+        return;
+    }
+
+    glNamedBufferSubData(ebo, getIndexOffset(slot), indices.size() * sizeof(uint32_t), indices.data());
+    slots[slot].indexCount = indices.size();
+    slots[slot].ready = true;
+}
+
+bool Rtin::extract(float maxError, VertexLayout layout) {
+    indices.clear();
+
+    // errors are non negative floats stored as uint, comparing the bits keeps the order
+    uint32_t maxErrorBits;
+    std::memcpy(&maxErrorBits, &maxError, sizeof(maxErrorBits));
+
+    const auto vertex = [layout](glm::ivec2 p) {
+        const glm::ivec2 clamped = glm::min(p, glm::ivec2(tileSize - 1));
+        return TerrainGen::vertexIndex(clamped.x, clamped.y, layout);
+    };
+
+    bool overflow = false;
+    const auto processTriangle = [&](const auto& self, glm::ivec2 a, glm::ivec2 b, glm::ivec2 c) -> void {
+        if (overflow) {
+            return;
+        }
+
+        const glm::ivec2 m = (a + b) / 2;
+        const glm::ivec2 legDiff = glm::abs(a - c);
+        if (legDiff.x + legDiff.y > 1 && errors[m.x + m.y * gridSize] > maxErrorBits) {
+            self(self, c, a, m);
+            self(self, b, c, m);
+            return;
+        }
+
+        if (indices.size() + 3 > maxTriangles * 3) {
+            overflow = true;
+            return;
+        }
+        indices.insert(indices.end(), {vertex(a), vertex(b), vertex(c)});
+    };
+
+    constexpr int32_t t = tileSize;
+    processTriangle(processTriangle, glm::ivec2(0, 0), glm::ivec2(t, t), glm::ivec2(t, 0));
+    processTriangle(processTriangle, glm::ivec2(t, t), glm::ivec2(0, 0), glm::ivec2(0, t));
+
+    return !overflow;
+}
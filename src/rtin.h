@@ -0,0 +1,71 @@
+#pragma once
+#include "shader_program.h"
+#include "terrain_gen.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Adaptive meshes for chunks as a right triangulated irregular network. The error map of a chunk is computed on the
+// gpu from its height map, read back asynchronously and turned into an index list for the requested error on the
+// cpu. One chunk is built at a time. A chunk is rebuilt when it is regenerated or its error budget changes.
+class Rtin {
+public:
+    static constexpr uint32_t tileSize = TerrainGen::chunkSize;
+    static constexpr uint32_t gridSize = tileSize + 1; // rtin needs 2^k + 1 samples, the last one repeats the edge
+    static constexpr uint32_t levelCount = 20;          // 2 * log2(tileSize)
+    static constexpr uint32_t maxTriangles = 1 << 17;  // per chunk, denser meshes fall back to the full grid
+    static constexpr uint32_t errorBinding = 1;         // storage block of the errors in rtin_error.comp
+    static_assert((1u << (levelCount / 2)) == tileSize, "level count must match the tile size");
+
+    Rtin(uint32_t chunkCount);
+
+    Rtin(const Rtin& other) = delete;
+    Rtin& operator=(const Rtin& other) = delete;
+
+    ~Rtin();
+
+    // slots that hold a new chunk, their meshes are dropped and rebuilt
+    void invalidate(const std::vector<uint32_t>& slots);
+    // allowed error in height map units. budgets are rounded down to a power of 2 so a chunk is only rebuilt when the
+    // budget changes by at least a factor of 2
+    void setMaxError(uint32_t slot, float maxError);
+
+    // finishes a pending build when the gpu is done with it and starts the next one. never waits on the gpu
+    void update(const ShaderProgram& errorShader, uint32_t heightMapId, VertexLayout layout);
+
+    bool isReady(uint32_t slot) const { return slots[slot].ready; }
+    uint32_t getIndexCount(uint32_t slot) const { return slots[slot].indexCount; }
+    // byte offset of the indices of the slot in the index buffer
+    size_t getIndexOffset(uint32_t slot) const { return slot * maxTriangles * 3 * sizeof(uint32_t); }
+    uint32_t getIndexBuffer() const { return ebo; }
+    bool isBuilding() const { return building != noSlot || !buildQueue.empty(); }
+
+private:
+    struct Slot {
+        bool ready = false;
+        bool queued = false;
+        float maxError = 0.0f;
+        uint32_t indexCount = 0;
+        uint32_t version = 0; // bumped on invalidation, so a build of the old chunk is dropped
+    };
+
+    void queue(uint32_t slot);
+    void startBuild(const ShaderProgram& errorShader, uint32_t heightMapId, uint32_t slot);
+    void finishBuild(VertexLayout layout);
+    bool extract(float maxError, VertexLayout layout);
+
+    std::vector<Slot> slots;
+    std::deque<uint32_t> buildQueue;
+
+    static constexpr uint32_t noSlot = UINT32_MAX;
+    uint32_t building = noSlot;
+    uint32_t buildingVersion = 0;
+    float buildingError = 0.0f;
+    GLsync fence = nullptr;
+
+    std::vector<uint32_t> errors;
+    std::vector<uint32_t> indices;
+
+    uint32_t errorBuffer;
+    uint32_t ebo;
+};
@@ -1,20 +1,93 @@
 #include "shader.h"
+#include <algorithm>
 #include <array>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 static std::array<char, 1024> compileInfo{};
 
-Shader::Shader(const std::string& source, ShaderType type) {
+static const std::string includeDir = "res/shaders/";
+
+// #line directives around an included file keep the line numbers in compile errors matching the including file
+static std::string expandIncludes(const std::string& source) {
+    std::istringstream lines(source);
+    std::string result;
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        const size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+            result += line + "\n";
+            continue;
+        }
+
+        const size_t open = line.find('"', start);
+        const size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            throw std::runtime_error("malformed shader include: " + line);
+        }
+        const std::string name = line.substr(open + 1, close - open - 1);
+        std::ifstream file(includeDir + name);
+        if (!file) {
+            throw std::runtime_error("failed to open shader include " + name);
+        }
+        std::stringstream included;
+        included << file.rdbuf();
+
+        result += "#line 1\n" + expandIncludes(included.str()) + "#line " + std::to_string(lineNumber + 1) + "\n";
+    }
+    return result;
+}
+
+static std::string injectDefines(const std::string& source, const std::vector<std::string>& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+
+    std::string defineLines;
+    for (const auto& define : defines) {
+        defineLines += "#define " + define + "\n";
+    }
+
+    // #version has to stay the first directive
+    const size_t version = source.find("#version");
+    const size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return defineLines + source;
+    }
+
+    // keep line numbers in compile errors matching the file
+    const std::string head = source.substr(0, lineEnd + 1);
+    const auto nextLine = std::count(head.begin(), head.end(), '\n') + 1;
+    return head + defineLines + "#line " + std::to_string(nextLine) + "\n" + source.substr(lineEnd + 1);
+}
+
+Shader::Shader(const std::string& source, ShaderType type, const std::vector<std::string>& defines)
+    : source(injectDefines(expandIncludes(source), defines)), type(type) {}
+
+uint32_t Shader::handle() const {
+    if (id != 0) {
+        return id;
+    }
+
     const char* src = source.c_str();
     id = glCreateShader(static_cast<GLenum>(type));
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
+    return id;
+}
 
+bool Shader::checkCompileStatus(uint32_t shader) {
     int success = 0;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
-        glGetShaderInfoLog(id, compileInfo.size(), nullptr, compileInfo.data());
-        std::cerr << "ERROR: shader compilation of type " << static_cast<GLenum>(type) << " failed\n"
-                  << compileInfo.data() << std::endl;
+        int type = 0;
+        glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+        glGetShaderInfoLog(shader, compileInfo.size(), nullptr, compileInfo.data());
+        std::cerr << "ERROR: shader compilation of type " << type << " failed\n" << compileInfo.data() << std::endl;
     }
+    return success;
 }
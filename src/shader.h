@@ -3,28 +3,45 @@
 #include <glad/gl.h>
 #include <string>
 #include <utility>
+#include <vector>
 
 enum class ShaderType : GLenum {
     Vertex = GL_VERTEX_SHADER,
     Fragment = GL_FRAGMENT_SHADER,
+    TessControl = GL_TESS_CONTROL_SHADER,
+    TessEvaluation = GL_TESS_EVALUATION_SHADER,
     Compute = GL_COMPUTE_SHADER,
 };
 
 class Shader {
 public:
-    Shader(const std::string& source, ShaderType type);
+    // #include "name" lines are replaced with the file from res/shaders, for snippets shared between shaders. defines
+    // are inserted as #define lines after the #version directive, to build variants of a single source.
+    // compiling is deferred to the first handle() call, a program loaded from the binary cache never needs it
+    Shader(const std::string& source, ShaderType type, const std::vector<std::string>& defines = {});
 
     Shader(const Shader& other) = delete;
     Shader& operator=(const Shader& other) = delete;
 
-    Shader(Shader&& other) noexcept : id(std::exchange(other.id, 0)) {}
+    Shader(Shader&& other) noexcept
+        : source(std::move(other.source)), type(other.type), id(std::exchange(other.id, 0)) {}
 
     Shader& operator=(Shader&& other) noexcept {
+        source = std::move(other.source);
+        type = other.type;
         id = std::exchange(other.id, 0);
         return *this;
     }
 
-    uint32_t handle() const { return id; }
+    // submits the compile on the first call, without waiting for it
+    uint32_t handle() const;
+
+    // prints the log of a shader that failed to compile, blocks until the compile is done
+    static bool checkCompileStatus(uint32_t shader);
+
+    // source with the defines inserted
+    const std::string& getSource() const { return source; }
+    ShaderType getType() const { return type; }
 
     ~Shader() {
         if (id != 0) {
@@ -33,5 +50,7 @@ public:
     }
 
 private:
-    uint32_t id;
+    std::string source;
+    ShaderType type;
+    mutable uint32_t id = 0;
 };
@@ -1,26 +1,377 @@
 #include "shader_program.h"
 #include "shader.h"
+#include <algorithm>
 #include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <glad/gl.h>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <iterator>
+#include <unordered_set>
 
 static std::array<char, 1024> linkInfo{};
 
-ShaderProgram::ShaderProgram(std::initializer_list<Shader> shaders) {
+static const char* const binaryCacheDir = "shader_cache";
+// entries of the programs created in this run, everything else in the cache is stale
+static std::unordered_set<std::string> usedCachePaths;
+
+// GL_KHR_parallel_shader_compile and GL_ARB_parallel_shader_compile share the enum
+constexpr GLenum completionStatus = 0x91B1;
+typedef void(GLAD_API_PTR* MaxShaderCompilerThreadsFunc)(GLuint count);
+static bool parallelCompile = false;
+constexpr uint32_t binaryMagic = 0x50424331; // PBC1
+
+// fnv-1a, stable between runs unlike std::hash
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+// empty if the driver has no binary formats
+static std::string binaryCachePath(std::initializer_list<Shader> shaders) {
+    int32_t formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0) {
+        return "";
+    }
+
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const auto* str = reinterpret_cast<const char*>(glGetString(name));
+        hash = hashBytes(hash, str, std::strlen(str) + 1);
+    }
+    for (const auto& s : shaders) {
+        const ShaderType type = s.getType();
+        hash = hashBytes(hash, &type, sizeof(type));
+        hash = hashBytes(hash, s.getSource().c_str(), s.getSource().size() + 1);
+    }
+
+    std::array<char, 17> name{};
+    std::snprintf(name.data(), name.size(), "%016llx", static_cast<unsigned long long>(hash));
+    return std::string(binaryCacheDir) + "/" + name.data() + ".bin";
+}
+
+bool ShaderProgram::initParallelCompile(GLADloadfunc load) {
+    int32_t extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (int32_t i = 0; i < extensionCount && !parallelCompile; i++) {
+        const std::string_view name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        const char* const function = name == "GL_KHR_parallel_shader_compile"   ? "glMaxShaderCompilerThreadsKHR"
+                                     : name == "GL_ARB_parallel_shader_compile" ? "glMaxShaderCompilerThreadsARB"
+                                                                                : nullptr;
+        const auto maxThreads = function ? reinterpret_cast<MaxShaderCompilerThreadsFunc>(load(function)) : nullptr;
+        if (maxThreads) {
+            // as many threads as the driver wants
+            maxThreads(0xFFFFFFFF);
+            parallelCompile = true;
+        }
+    }
+    return parallelCompile;
+}
+
+ShaderProgram::ShaderProgram(std::initializer_list<Shader> shaders) : cachePath(binaryCachePath(shaders)) {
+    if (!cachePath.empty()) {
+        usedCachePaths.insert(cachePath);
+    }
+
+    // loading a binary is cheap, only compiling from source is worth overlapping with other work
+    if (!cachePath.empty() && loadBinary(cachePath)) {
+        finished = true;
+        reflect();
+        return;
+    }
+
+    submitLink(shaders);
+}
+
+void ShaderProgram::submitLink(std::initializer_list<Shader> shaders) {
     id = glCreateProgram();
+    glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
+    // every shader is submitted before the link, the status is not queried until finish()
     for (const auto& s : shaders) {
         glAttachShader(id, s.handle());
     }
 
+    // the shaders are only flagged for deletion while they are attached, so their logs can still be read on failure
     glLinkProgram(id);
+}
+
+bool ShaderProgram::isReady() const {
+    if (finished || !parallelCompile) {
+        return true;
+    }
+
+    int32_t complete = GL_FALSE;
+    glGetProgramiv(id, completionStatus, &complete);
+    return complete;
+}
+
+void ShaderProgram::finish() {
+    if (finished) {
+        return;
+    }
+    finished = true;
 
     int success;
     glGetProgramiv(id, GL_LINK_STATUS, &success);
     if (!success) {
+        std::array<uint32_t, 8> attached{};
+        int32_t attachedCount = 0;
+        glGetAttachedShaders(id, attached.size(), &attachedCount, attached.data());
+        for (int32_t i = 0; i < attachedCount; i++) {
+            Shader::checkCompileStatus(attached[i]);
+        }
+
         glGetProgramInfoLog(id, linkInfo.size(), nullptr, linkInfo.data());
         std::cerr << "ERROR: shaders failed to link\n" << linkInfo.data() << std::endl;
+    } else if (!cachePath.empty()) {
+        saveBinary(cachePath);
     }
 
     glValidateProgram(id);
+    reflect();
+}
+
+bool ShaderProgram::loadBinary(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    uint32_t magic = 0;
+    GLenum format = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    if (!file || magic != binaryMagic) {
+        return false;
+    }
+    const std::vector<char> binary(std::istreambuf_iterator<char>(file), {});
+
+    id = glCreateProgram();
+    glProgramBinary(id, format, binary.data(), binary.size());
+
+    // a driver update can reject the format or the binary, the program is linked from source again then
+    int success;
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(id);
+        id = 0;
+        return false;
+    }
+    return true;
+}
+
+void ShaderProgram::saveBinary(const std::string& path) const {
+    int32_t success = 0;
+    int32_t length = 0;
+    glGetProgramiv(id, GL_LINK_STATUS, &success);
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!success || length == 0) {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(id, length, nullptr, &format, binary.data());
+
+    // the cache only saves time, failing to write it is not an error. the file is written next to its place and
+    // renamed into it, so a crash never leaves a truncated entry behind under a valid name
+    std::error_code error;
+    std::filesystem::create_directories(binaryCacheDir, error);
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&binaryMagic), sizeof(binaryMagic));
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(binary.data(), binary.size());
+        file.close();
+        if (!file) {
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+void ShaderProgram::pruneBinaryCache() {
+    std::error_code error;
+    std::vector<std::filesystem::path> stale;
+    // a missing directory only means there is nothing cached
+    for (std::filesystem::directory_iterator it(binaryCacheDir, error), end; !error && it != end; it.increment(error)) {
+        if (usedCachePaths.count(std::string(binaryCacheDir) + "/" + it->path().filename().string()) == 0) {
+            stale.push_back(it->path());
+        }
+    }
+    for (const auto& path : stale) {
+        std::filesystem::remove(path, error);
+    }
+}
+
+static std::string resourceName(uint32_t program, GLenum interface, uint32_t index, int32_t length) {
+    std::string name(length, '\0');
+    glGetProgramResourceName(program, interface, index, length, nullptr, name.data());
+    name.resize(std::strlen(name.c_str()));
+
+    // arrays are reported as their first element
+    if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+        name.resize(name.size() - 3);
+    }
+    return name;
+}
+
+std::vector<ShaderProgram::Block> ShaderProgram::reflectBlocks(uint32_t program, GLenum interface) {
+    int32_t count = 0;
+    glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+
+    std::vector<Block> blocks;
+    for (int32_t i = 0; i < count; i++) {
+        const std::array<GLenum, 2> props{GL_NAME_LENGTH, GL_BUFFER_BINDING};
+        std::array<int32_t, 2> results{};
+        glGetProgramResourceiv(program, interface, i, props.size(), props.data(), results.size(), nullptr,
+            results.data());
+        blocks.push_back({resourceName(program, interface, i, results[0]), results[1]});
+    }
+    return blocks;
+}
+
+void ShaderProgram::reflect() {
+    int32_t count = 0;
+    glGetProgramInterfaceiv(id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+    for (int32_t i = 0; i < count; i++) {
+        const std::array<GLenum, 3> props{GL_NAME_LENGTH, GL_LOCATION, GL_BLOCK_INDEX};
+        std::array<int32_t, 3> results{};
+        glGetProgramResourceiv(id, GL_UNIFORM, i, props.size(), props.data(), results.size(), nullptr, results.data());
+
+        // members of blocks have no location, they are set through buffers
+        if (results[2] != -1 || results[1] == -1) {
+            continue;
+        }
+        uniforms.push_back({resourceName(id, GL_UNIFORM, i, results[0]), results[1]});
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(), [](const Uniform& a, const Uniform& b) { return a.name < b.name; });
+    values.resize(uniforms.size());
+
+    uniformBlocks = reflectBlocks(id, GL_UNIFORM_BLOCK);
+    storageBlocks = reflectBlocks(id, GL_SHADER_STORAGE_BLOCK);
+}
+
+int32_t ShaderProgram::findUniform(std::string_view name) const {
+    const auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name,
+        [](const Uniform& uniform, std::string_view name) { return uniform.name < name; });
+    return it != uniforms.end() && it->name == name ? static_cast<int32_t>(it - uniforms.begin()) : -1;
+}
+
+int32_t ShaderProgram::findBinding(const std::vector<Block>& blocks, std::string_view name) {
+    const auto it = std::find_if(blocks.begin(), blocks.end(), [&](const auto& block) { return block.name == name; });
+    return it != blocks.end() ? it->binding : -1;
+}
+
+int32_t ShaderProgram::uniformBlockBinding(std::string_view name) const {
+    return findBinding(uniformBlocks, name);
+}
+
+int32_t ShaderProgram::storageBlockBinding(std::string_view name) const {
+    return findBinding(storageBlocks, name);
+}
+
+bool ShaderProgram::update(int32_t uniform, const void* data, size_t size) const {
+    if (uniform < 0) {
+        return false;
+    }
+
+    std::vector<std::byte>& value = values[uniform];
+    if (value.size() == size && std::memcmp(value.data(), data, size) == 0) {
+        return false;
+    }
+
+    value.resize(size);
+    std::memcpy(value.data(), data, size);
+    return true;
+}
+
+void ShaderProgram::set(int32_t uniform, float value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform1f(id, uniforms[uniform].location, value);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, int32_t value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform1i(id, uniforms[uniform].location, value);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, uint32_t value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform1ui(id, uniforms[uniform].location, value);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, glm::vec2 value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform2f(id, uniforms[uniform].location, value.x, value.y);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, glm::vec3 value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform3f(id, uniforms[uniform].location, value.x, value.y, value.z);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, glm::vec4 value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform4f(id, uniforms[uniform].location, value.x, value.y, value.z, value.w);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, glm::ivec2 value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform2i(id, uniforms[uniform].location, value.x, value.y);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, glm::uvec2 value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniform2ui(id, uniforms[uniform].location, value.x, value.y);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, const glm::mat4& value) const {
+    if (update(uniform, &value, sizeof(value))) {
+        glProgramUniformMatrix4fv(id, uniforms[uniform].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, const int32_t* data, int32_t count) const {
+    if (update(uniform, data, sizeof(int32_t) * count)) {
+        glProgramUniform1iv(id, uniforms[uniform].location, count, data);
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, const glm::vec2* data, int32_t count) const {
+    if (update(uniform, data, sizeof(glm::vec2) * count)) {
+        glProgramUniform2fv(id, uniforms[uniform].location, count, reinterpret_cast<const float*>(data));
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, const glm::vec4* data, int32_t count) const {
+    if (update(uniform, data, sizeof(glm::vec4) * count)) {
+        glProgramUniform4fv(id, uniforms[uniform].location, count, reinterpret_cast<const float*>(data));
+    }
+}
+
+void ShaderProgram::set(int32_t uniform, const glm::mat4* data, int32_t count) const {
+    if (update(uniform, data, sizeof(glm::mat4) * count)) {
+        glProgramUniformMatrix4fv(
+            id, uniforms[uniform].location, count, GL_FALSE, reinterpret_cast<const float*>(data));
+    }
 }
@@ -1,24 +1,88 @@
 #pragma once
 #include "shader.h"
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
 
 class ShaderProgram {
 public:
+    // linked programs are cached on disk as driver specific binaries. the cache is keyed by the shader sources with
+    // their defines and the gl vendor, renderer and version, anything that does not load falls back to compiling.
+    // compiling and linking is only submitted here, finish() has to be called before the program is used
     ShaderProgram(std::initializer_list<Shader> shaders);
 
+    // lets the driver compile and link on its own threads if it supports GL_KHR_parallel_shader_compile or the arb
+    // version, so programs that are submitted together compile in parallel. glad is generated without extensions, so
+    // the entry point is loaded here. returns whether it is supported
+    static bool initParallelCompile(GLADloadfunc load);
+    // deletes the cache entries of programs that were not created in this run, left behind by edited shaders or
+    // interrupted writes. call once every program exists
+    static void pruneBinaryCache();
+
     ShaderProgram(const ShaderProgram& other) = delete;
     ShaderProgram& operator=(const ShaderProgram& other) = delete;
 
-    ShaderProgram(ShaderProgram&& other) noexcept : id(std::exchange(other.id, 0)) {}
+    ShaderProgram(ShaderProgram&& other) noexcept
+        : id(std::exchange(other.id, 0)), finished(other.finished), cachePath(std::move(other.cachePath)),
+          uniforms(std::move(other.uniforms)), values(std::move(other.values)),
+          uniformBlocks(std::move(other.uniformBlocks)), storageBlocks(std::move(other.storageBlocks)) {}
 
     ShaderProgram& operator=(ShaderProgram&& other) noexcept {
         id = std::exchange(other.id, 0);
+        finished = other.finished;
+        cachePath = std::move(other.cachePath);
+        uniforms = std::move(other.uniforms);
+        values = std::move(other.values);
+        uniformBlocks = std::move(other.uniformBlocks);
+        storageBlocks = std::move(other.storageBlocks);
         return *this;
     }
 
+    // false while the driver is still compiling or linking. always true without parallel compile support, finish()
+    // blocks then
+    bool isReady() const;
+    // waits for the link, reports errors, stores the binary in the cache and reflects the interface
+    void finish();
+
     void bind() const { glUseProgram(id); }
 
     uint32_t handle() const { return id; };
 
+    // index of an active uniform in the table reflected at link time, -1 if there is none with that name. arrays are
+    // found by their name without [0]
+    int32_t findUniform(std::string_view name) const;
+    // binding points of uniform and shader storage blocks, -1 if the block is not active
+    int32_t uniformBlockBinding(std::string_view name) const;
+    int32_t storageBlockBinding(std::string_view name) const;
+
+    // the setters skip the gl call when the uniform already holds the value, so every uniform of the program has to be
+    // set through them. inactive uniforms (-1) are ignored
+    void set(int32_t uniform, float value) const;
+    void set(int32_t uniform, int32_t value) const;
+    void set(int32_t uniform, uint32_t value) const;
+    void set(int32_t uniform, glm::vec2 value) const;
+    void set(int32_t uniform, glm::vec3 value) const;
+    void set(int32_t uniform, glm::vec4 value) const;
+    void set(int32_t uniform, glm::ivec2 value) const;
+    void set(int32_t uniform, glm::uvec2 value) const;
+    void set(int32_t uniform, const glm::mat4& value) const;
+    void set(int32_t uniform, const int32_t* data, int32_t count) const;
+    void set(int32_t uniform, const glm::vec2* data, int32_t count) const;
+    void set(int32_t uniform, const glm::vec4* data, int32_t count) const;
+    void set(int32_t uniform, const glm::mat4* data, int32_t count) const;
+
+    // looks the name up in the table, no gl call unless the value changed
+    template <typename T>
+    void set(std::string_view name, const T& value) const {
+        set(findUniform(name), value);
+    }
+    template <typename T>
+    void set(std::string_view name, const T* data, int32_t count) const {
+        set(findUniform(name), data, count);
+    }
+
     ~ShaderProgram() {
         if (id != 0) {
             glDeleteProgram(id);
@@ -26,5 +90,32 @@ public:
     }
 
 private:
+    struct Uniform {
+        std::string name;
+        int32_t location;
+    };
+
+    struct Block {
+        std::string name;
+        int32_t binding;
+    };
+
+    void submitLink(std::initializer_list<Shader> shaders);
+    // false if there is no binary or the driver rejects it
+    bool loadBinary(const std::string& path);
+    void saveBinary(const std::string& path) const;
+    void reflect();
+    static std::vector<Block> reflectBlocks(uint32_t program, GLenum interface);
+    static int32_t findBinding(const std::vector<Block>& blocks, std::string_view name);
+    // compares the bytes with the last value of the uniform and stores them, false if nothing changed
+    bool update(int32_t uniform, const void* data, size_t size) const;
+
     uint32_t id;
+    bool finished = false;
+    std::string cachePath; // empty if the driver has no binary formats
+
+    std::vector<Uniform> uniforms; // sorted by name
+    mutable std::vector<std::vector<std::byte>> values; // last value set per uniform, empty until the first set
+    std::vector<Block> uniformBlocks;
+    std::vector<Block> storageBlocks;
 };
@@ -0,0 +1,155 @@
+#include "shadow_cascades.h"
+#include <algorithm>
+#include <glad/gl.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+// sync with shader.frag
+static const glm::vec3 sunDir = glm::normalize(glm::vec3(0.4f, 0.8f, 0.3f));
+
+ShadowCascades::ShadowCascades(uint32_t chunkCount)
+    : lightView(glm::lookAt(glm::vec3(0.0f), -sunDir, glm::vec3(0.0f, 1.0f, 0.0f))), renderedBounds(chunkCount) {
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+    glTextureStorage3D(texture, 1, GL_DEPTH_COMPONENT32F, resolution, resolution, cascadeCount);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTextureParameteri(texture, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    glCreateFramebuffers(1, &fbo);
+    glNamedFramebufferDrawBuffer(fbo, GL_NONE);
+    glNamedFramebufferReadBuffer(fbo, GL_NONE);
+}
+
+ShadowCascades::~ShadowCascades() {
+    glDeleteTextures(1, &texture);
+    glDeleteFramebuffers(1, &fbo);
+}
+
+void ShadowCascades::invalidate() {
+    for (auto& cascade : cascades) {
+        cascade.valid = false;
+    }
+}
+
+glm::mat4 ShadowCascades::cascadeProj(glm::vec3 center, float extent) const {
+    // snapped to whole texels, so the shadow edges do not shimmer when the cascade moves
+    const glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+    const float texel = extent / resolution;
+    const glm::vec2 snapped = glm::floor(glm::vec2(lightCenter.x, lightCenter.y) / texel) * texel;
+
+    const float half = extent * 0.5f;
+    const float depthRange = extent + std::abs(renderedScale) + 100.0f;
+    return glm::ortho(snapped.x - half, snapped.x + half, snapped.y - half, snapped.y + half,
+        -lightCenter.z - depthRange, -lightCenter.z + depthRange);
+}
+
+glm::ivec4 ShadowCascades::chunkRect(uint32_t cascade, const ChunkBounds& bounds) const {
+    const float minY = std::min(0.0f, renderedScale);
+    const float maxY = std::max(0.0f, renderedScale);
+
+    glm::vec2 lo(1.0f);
+    glm::vec2 hi(-1.0f);
+    for (uint32_t i = 0; i < 8; i++) {
+        const glm::vec3 corner((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? maxY : minY,
+            (i & 4) ? bounds.max.y : bounds.min.y);
+        const glm::vec4 clip = viewProjs[cascade] * glm::vec4(corner, 1.0f);
+        lo = glm::min(lo, glm::vec2(clip.x, clip.y));
+        hi = glm::max(hi, glm::vec2(clip.x, clip.y));
+    }
+
+    const glm::ivec2 start = glm::clamp(glm::ivec2(glm::floor((lo * 0.5f + 0.5f) * float(resolution))), 0, resolution);
+    const glm::ivec2 end = glm::clamp(glm::ivec2(glm::ceil((hi * 0.5f + 0.5f) * float(resolution))), 0, resolution);
+    return glm::ivec4(start, glm::max(end - start, 0));
+}
+
+void ShadowCascades::render(uint32_t cascade, glm::ivec4 rect, const TerrainGen& terrainGen,
+    const std::function<void(uint32_t)>& drawChunk) {
+    if (rect.z == 0 || rect.w == 0) {
+        return;
+    }
+
+    glNamedFramebufferTextureLayer(fbo, GL_DEPTH_ATTACHMENT, texture, 0, cascade);
+    glScissor(rect.x, rect.y, rect.z, rect.w);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    for (uint32_t slot = 0; slot < renderedBounds.size(); slot++) {
+        const glm::ivec4 chunk = chunkRect(cascade, terrainGen.getChunkBounds(slot));
+        const bool overlaps = chunk.x < rect.x + rect.z && rect.x < chunk.x + chunk.z && chunk.y < rect.y + rect.w &&
+                              rect.y < chunk.y + chunk.w;
+        if (overlaps) {
+            drawChunk(slot);
+            drawCount++;
+        }
+    }
+}
+
+void ShadowCascades::update(const ShaderProgram& depthShader, UniformRing& uniformRing, const FrameData& frameData,
+    const TerrainGen& terrainGen, const std::vector<uint32_t>& generatedSlots,
+    const std::function<void(uint32_t)>& drawChunk) {
+    drawCount = 0;
+    if (frameData.heightScale != renderedScale || frameData.heightPower != renderedPower) {
+        renderedScale = frameData.heightScale;
+        renderedPower = frameData.heightPower;
+        invalidate();
+    }
+
+    // the scene may be rendering into an offscreen target
+    std::array<int32_t, 4> viewport;
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+    int32_t framebuffer;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, resolution, resolution);
+    glEnable(GL_SCISSOR_TEST);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    const glm::mat4 model(1.0f);
+    depthShader.bind();
+    depthShader.set("model", model);
+
+    FrameData lightData = frameData;
+    lightData.view = lightView;
+
+    const glm::ivec4 fullRect(0, 0, resolution, resolution);
+    for (uint32_t i = 0; i < cascadeCount; i++) {
+        Cascade& cascade = cascades[i];
+        const glm::vec2 camXZ(frameData.camPos.x, frameData.camPos.z);
+        const float step = extents[i] / 4.0f;
+        const glm::vec2 center = i == 0 ? camXZ : glm::floor(camXZ / step) * step;
+
+        const bool moved = i == 0 || !cascade.valid || center != cascade.center;
+        if (moved) {
+            cascade.proj = cascadeProj(glm::vec3(center.x, 0.0f, center.y), extents[i]);
+            cascade.center = center;
+            cascade.valid = true;
+            viewProjs[i] = cascade.proj * lightView;
+        }
+
+        lightData.proj = cascade.proj;
+        lightData.viewProj = viewProjs[i];
+        uniformRing.bind(frameDataBinding, uniformRing.push(lightData), sizeof(FrameData));
+
+        if (moved) {
+            render(i, fullRect, terrainGen, drawChunk);
+            continue;
+        }
+
+        // where the old chunk of a slot was and where the new one is
+        for (const uint32_t slot : generatedSlots) {
+            render(i, chunkRect(i, renderedBounds[slot]), terrainGen, drawChunk);
+            render(i, chunkRect(i, terrainGen.getChunkBounds(slot)), terrainGen, drawChunk);
+        }
+    }
+
+    for (uint32_t slot = 0; slot < renderedBounds.size(); slot++) {
+        renderedBounds[slot] = terrainGen.getChunkBounds(slot);
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "frame_data.h"
+#include "shader_program.h"
+#include "terrain_gen.h"
+#include "uniform_ring.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Cascaded sun shadow maps that are cached between frames. Only the nearest cascade is rendered every frame. The
+// others stay in place until the camera moved a quarter of their size, and in between only the regions covered by
+// replaced chunks are cleared and rendered again.
+class ShadowCascades {
+public:
+    static constexpr uint32_t cascadeCount = 3; // sync with shader.frag
+    static constexpr int32_t resolution = 2048;
+    static constexpr std::array<float, cascadeCount> extents{1024.0f, 4096.0f, 12288.0f}; // world units per side
+
+    ShadowCascades(uint32_t chunkCount);
+
+    ShadowCascades(const ShadowCascades& other) = delete;
+    ShadowCascades& operator=(const ShadowCascades& other) = delete;
+
+    ~ShadowCascades();
+
+    // drawChunk draws the chunk in a buffer slot with the depth shader bound. the light matrices of each cascade are
+    // pushed into the uniform ring as a copy of frameData, so the frame block has to be bound again afterwards
+    void update(const ShaderProgram& depthShader, UniformRing& uniformRing, const FrameData& frameData,
+        const TerrainGen& terrainGen, const std::vector<uint32_t>& generatedSlots,
+        const std::function<void(uint32_t)>& drawChunk);
+
+    // render all cascades completely on the next update
+    void invalidate();
+
+    const std::array<glm::mat4, cascadeCount>& getViewProjs() const { return viewProjs; }
+    uint32_t getTexture() const { return texture; }
+    uint32_t getDrawCount() const { return drawCount; }
+
+private:
+    struct Cascade {
+        glm::mat4 proj{1.0f};
+        glm::vec2 center{0.0f};
+        bool valid = false;
+    };
+
+    glm::mat4 cascadeProj(glm::vec3 center, float extent) const;
+    // texels covered by the chunk in a slot as x, y, width, height. empty if it is outside the cascade
+    glm::ivec4 chunkRect(uint32_t cascade, const ChunkBounds& bounds) const;
+    // clears the rect and draws every chunk that overlaps it
+    void render(uint32_t cascade, glm::ivec4 rect, const TerrainGen& terrainGen,
+        const std::function<void(uint32_t)>& drawChunk);
+
+    glm::mat4 lightView;
+    std::array<Cascade, cascadeCount> cascades;
+    std::array<glm::mat4, cascadeCount> viewProjs;
+
+    std::vector<ChunkBounds> renderedBounds; // bounds of the chunk a slot held when it was last rendered
+    float renderedScale = 0.0f;
+    float renderedPower = 0.0f;
+    uint32_t drawCount = 0;
+
+    uint32_t texture;
+    uint32_t fbo;
+};
@@ -1,22 +1,39 @@
 #include "terrain_gen.h"
+#include <algorithm>
+#include <cassert>
 
-void TerrainGen::genChunk(
-    const ShaderProgram& terrainShader, uint32_t vertexId, glm::ivec2 chunkIdx, uint32_t buffIdx) const {
+void TerrainGen::genChunk(const ShaderProgram& terrainShader, uint32_t vertexId, uint32_t heightMapId,
+    uint32_t splatMapId, glm::ivec2 chunkIdx, uint32_t buffIdx) const {
 
     terrainShader.bind();
-    glUniform1ui(glGetUniformLocation(terrainShader.handle(), "gridSize"), config.gridSize);
-    glUniform1ui(glGetUniformLocation(terrainShader.handle(), "octaves"), config.octaves);
-    glUniform1f(glGetUniformLocation(terrainShader.handle(), "lacunarity"), config.lacunarity);
-    glUniform1f(glGetUniformLocation(terrainShader.handle(), "gain"), config.gain);
-    glUniform2i(glGetUniformLocation(terrainShader.handle(), "chunkIdx"), chunkIdx.x, chunkIdx.y);
-    glUniform2i(glGetUniformLocation(terrainShader.handle(), "centerIdx"), currentCenter.x, currentCenter.y);
-    glUniform1ui(glGetUniformLocation(terrainShader.handle(), "buffIdx"), buffIdx);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vertexId);
+    terrainShader.set(uniforms.gridSize, config.gridSize);
+    terrainShader.set(uniforms.octaves, config.octaves);
+    terrainShader.set(uniforms.lacunarity, config.lacunarity);
+    terrainShader.set(uniforms.gain, config.gain);
+    terrainShader.set(uniforms.chunkIdx, chunkIdx);
+    terrainShader.set(uniforms.centerIdx, currentCenter);
+    terrainShader.set(uniforms.buffIdx, buffIdx);
+    terrainShader.set(uniforms.vertexLayout, static_cast<uint32_t>(vertexLayout));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, vertexBinding, vertexId);
+    glBindImageTexture(0, heightMapId, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R16);
+    glBindImageTexture(1, splatMapId, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8);
     glDispatchCompute(chunkSize / 8, chunkSize / 8, 1);
-    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
 }
 
-void TerrainGen::update(const ShaderProgram& terrainShader, uint32_t vertexId, glm::ivec2 center) {
+void TerrainGen::findUniforms(const ShaderProgram& terrainShader) {
+    uniforms.gridSize = terrainShader.findUniform("gridSize");
+    uniforms.octaves = terrainShader.findUniform("octaves");
+    uniforms.lacunarity = terrainShader.findUniform("lacunarity");
+    uniforms.gain = terrainShader.findUniform("gain");
+    uniforms.chunkIdx = terrainShader.findUniform("chunkIdx");
+    uniforms.centerIdx = terrainShader.findUniform("centerIdx");
+    uniforms.buffIdx = terrainShader.findUniform("buffIdx");
+    uniforms.vertexLayout = terrainShader.findUniform("vertexLayout");
+}
+
+std::vector<uint32_t> TerrainGen::update(const ShaderProgram& terrainShader, uint32_t vertexId, uint32_t heightMapId,
+    uint32_t splatMapId, glm::ivec2 center) {
     currentCenter = center;
     const auto goodChunks = getChunksInRange(center);
 
@@ -42,20 +59,38 @@ void TerrainGen::update(const ShaderProgram& terrainShader, uint32_t vertexId, g
     }
 
     // generate new chunks
+    std::vector<uint32_t> generated;
+    generated.reserve(toAlloc.size());
+    const auto gen = [&](glm::ivec2 chunk, uint32_t idx) {
+        genChunk(terrainShader, vertexId, heightMapId, splatMapId, chunk, idx);
+        allocatedChunks.insert(std::make_pair(chunk, idx));
+        slotOrigins[idx] = glm::vec2(chunk * static_cast<int32_t>(chunkSize) - (chunk - center));
+        slotChunks[idx] = chunk;
+        generated.push_back(idx);
+    };
+
     if (toFree.size() == toAlloc.size()) {
         for (uint32_t i = 0; i < toAlloc.size(); i++) {
-            const auto& [_, idx] = toFree[i];
-            genChunk(terrainShader, vertexId, toAlloc[i], idx);
-            allocatedChunks.insert(std::make_pair(toAlloc[i], idx));
+            gen(toAlloc[i], toFree[i].second);
         }
     } else {
         assert(toAlloc.size() == goodChunks.size());
         for (uint32_t i = 0; i < toAlloc.size(); i++) {
-            const auto& chunk = toAlloc[i];
-            genChunk(terrainShader, vertexId, chunk, i);
-            allocatedChunks.insert(std::make_pair(chunk, i));
+            gen(toAlloc[i], i);
         }
     }
+
+    return generated;
+}
+
+ChunkBounds TerrainGen::getChunkBounds(uint32_t slot) const {
+    const glm::vec2 origin = slotOrigins[slot];
+    return ChunkBounds{origin, origin + glm::vec2((chunkSize - 1) * sampleSpacing)};
+}
+
+int32_t TerrainGen::findSlot(glm::ivec2 chunk) const {
+    const auto it = allocatedChunks.find(chunk);
+    return it == allocatedChunks.end() ? -1 : static_cast<int32_t>(it->second);
 }
 
 uint32_t TerrainGen::getChunkCount() {
@@ -88,27 +123,97 @@ std::unordered_set<glm::ivec2> TerrainGen::getChunksInRange(glm::ivec2 center) c
     return points;
 }
 
-std::vector<uint32_t> TerrainGen::genHeightIndices() {
-    constexpr uint32_t w = chunkSize;
-    constexpr uint32_t h = chunkSize;
+// spreads the lower 16 bits of x out over the even bits
+static uint32_t part1By1(uint32_t x) {
+    x &= 0x0000ffff;
+    x = (x | (x << 8)) & 0x00ff00ff;
+    x = (x | (x << 4)) & 0x0f0f0f0f;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+    return x;
+}
+
+uint32_t TerrainGen::vertexIndex(uint32_t x, uint32_t y, VertexLayout layout) {
+    switch (layout) {
+    case VertexLayout::Morton:
+        return part1By1(x) | (part1By1(y) << 1);
+    case VertexLayout::RowMajor:
+    default:
+        return x + y * chunkSize;
+    }
+}
+
+// indices of a grid of w * h vertices, index maps a vertex position to its index
+template <typename T, typename F>
+static void pushGridIndices(std::vector<T>& indices, uint32_t w, uint32_t h, IndexOrder order, F&& index) {
+    const auto pushQuad = [&indices, &index](uint32_t i, uint32_t j) {
+        const T tl = index(i, j);
+        const T tr = index(i + 1, j);
+        const T bl = index(i, j + 1);
+        const T br = index(i + 1, j + 1);
+
+        indices.push_back(tl);
+        indices.push_back(bl);
+        indices.push_back(tr);
+
+        indices.push_back(bl);
+        indices.push_back(br);
+        indices.push_back(tr);
+    };
+
+    switch (order) {
+    case IndexOrder::RowMajor:
+        for (uint32_t j = 0; j < h - 1; j++) {
+            for (uint32_t i = 0; i < w - 1; i++) {
+                pushQuad(i, j);
+            }
+        }
+        break;
+    case IndexOrder::Strips:
+        for (uint32_t i0 = 0; i0 < w - 1; i0 += TerrainGen::indexStripWidth) {
+            const uint32_t i1 = std::min(i0 + TerrainGen::indexStripWidth, w - 1);
+            for (uint32_t j = 0; j < h - 1; j++) {
+                for (uint32_t i = i0; i < i1; i++) {
+                    pushQuad(i, j);
+                }
+            }
+        }
+        break;
+    }
+}
+
+std::vector<uint32_t> TerrainGen::genHeightIndices(IndexOrder order, VertexLayout layout) {
+    std::vector<uint32_t> indices;
+    indices.reserve(elemCount);
+    pushGridIndices(indices, chunkSize, chunkSize, order,
+        [layout](uint32_t x, uint32_t y) { return vertexIndex(x, y, layout); });
+
+    return indices;
+}
+
+std::vector<uint16_t> TerrainGen::genTileIndices(IndexOrder order) {
+    std::vector<uint16_t> indices;
+    indices.reserve(tileElemCount);
+    pushGridIndices(indices, tileSize, tileSize, order,
+        [](uint32_t x, uint32_t y) { return static_cast<uint16_t>(vertexIndex(x, y, VertexLayout::Morton)); });
+
+    return indices;
+}
 
+std::vector<uint32_t> TerrainGen::genSeamIndices() {
     std::vector<uint32_t> indices;
-    indices.reserve((w - 1) * (h - 1) * 2 * 3);
-
-    for (uint32_t j = 0; j < h - 1; j++) {
-        for (uint32_t i = 0; i < w - 1; i++) {
-            int32_t tl = i + j * w;
-            int32_t tr = i + 1 + j * w;
-            int32_t bl = i + (j + 1) * w;
-            int32_t br = i + 1 + (j + 1) * w;
-
-            indices.push_back(tl);
-            indices.push_back(bl);
-            indices.push_back(tr);
-
-            indices.push_back(bl);
-            indices.push_back(br);
-            indices.push_back(tr);
+    for (uint32_t j = 0; j < chunkSize - 1; j++) {
+        for (uint32_t i = 0; i < chunkSize - 1; i++) {
+            const bool seam = i % tileSize == tileSize - 1 || j % tileSize == tileSize - 1;
+            if (!seam) {
+                continue;
+            }
+
+            const uint32_t tl = vertexIndex(i, j, VertexLayout::Morton);
+            const uint32_t tr = vertexIndex(i + 1, j, VertexLayout::Morton);
+            const uint32_t bl = vertexIndex(i, j + 1, VertexLayout::Morton);
+            const uint32_t br = vertexIndex(i + 1, j + 1, VertexLayout::Morton);
+            indices.insert(indices.end(), {tl, bl, tr, bl, br, tr});
         }
     }
 
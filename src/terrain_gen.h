@@ -2,7 +2,6 @@
 #include "shader_program.h"
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
-#include <imgui.h>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -10,6 +9,25 @@
 // sync with terrain.comp
 struct Vertex {
     glm::vec3 pos;
+    uint32_t normal; // octahedral normal in the lower 2 * 12 bits, ambient occlusion in the upper 8
+};
+
+// horizontal extents of a generated chunk in world space
+struct ChunkBounds {
+    glm::vec2 min;
+    glm::vec2 max;
+};
+
+// triangle order of the shared chunk index buffer
+enum class IndexOrder {
+    RowMajor, // full rows, every vertex misses the post transform cache twice
+    Strips,   // narrow vertical strips, the previous row stays in the post transform cache
+};
+
+// placement of the vertices of a chunk inside its slot of the vertex buffer. sync with terrain.comp
+enum class VertexLayout : uint32_t {
+    RowMajor,
+    Morton, // z-order curve, vertices that are close in both directions are close in memory
 };
 
 struct GenConfig {
@@ -23,28 +41,81 @@ class TerrainGen {
 public:
     static constexpr uint32_t chunkSize = 1024;                                    // width and height of the chunk
     static constexpr size_t elemCount = (chunkSize - 1) * (chunkSize - 1) * 2 * 3; // index buffer count
+    static constexpr uint32_t indexStripWidth = 7; // quads per strip, two rows of it fit in a 16 entry fifo cache
+
+    // with the morton layout every aligned tile of tileSize^2 vertices is contiguous, so its triangles can be drawn
+    // with 16 bit indices and a base vertex. the quads between tiles (seams) are drawn separately with 32 bit indices
+    static constexpr uint32_t tileSize = 256;
+    static constexpr uint32_t tilesPerChunk = (chunkSize / tileSize) * (chunkSize / tileSize);
+    static constexpr size_t tileElemCount = (tileSize - 1) * (tileSize - 1) * 2 * 3;
+    static_assert(tileSize * tileSize <= 65536, "tile vertices must be addressable with 16 bit indices");
+    static_assert(chunkSize % tileSize == 0, "chunk size must be a multiple of the tile size");
+    static_assert((chunkSize & (chunkSize - 1)) == 0, "chunk size must be a power of 2 for the morton layout");
     static_assert(chunkSize % 8 == 0, "chunk size must be divisible by 8. keep in sync with layout in compute shader");
 
     // static constexpr uint32_t chunkCount = 41; // with manhattan distance 4
     static constexpr uint32_t chunkDistance = 4;
+    static constexpr float sampleSpacing = 1026.0f / 1024.0f; // sync with terrain.comp
+    static constexpr uint32_t vertexBinding = 0;             // storage block of the vertices in terrain.comp
 
     static uint32_t getChunkCount();
     static size_t getVertexBufferSize() { return chunkSize * chunkSize * sizeof(Vertex) * getChunkCount(); }
     static constexpr size_t getIndexBufferSize() { return elemCount * sizeof(uint32_t); }
 
-    static std::vector<uint32_t> genHeightIndices();
+    static uint32_t vertexIndex(uint32_t x, uint32_t y, VertexLayout layout);
+    static std::vector<uint32_t> genHeightIndices(
+        IndexOrder order = IndexOrder::Strips, VertexLayout layout = VertexLayout::RowMajor);
+    // local indices of a single tile, morton layout only
+    static std::vector<uint16_t> genTileIndices(IndexOrder order = IndexOrder::Strips);
+    // quads between the tiles of a chunk, morton layout only
+    static std::vector<uint32_t> genSeamIndices();
+
+    // looks up the uniforms of terrain.comp, once the shader is finished and before the first update
+    void findUniforms(const ShaderProgram& terrainShader);
+    // heightMapId and splatMapId are 2d array textures with a chunkSize^2 layer per buffer slot, GL_R16 heights and
+    // GL_RGBA8 material weights. returns the buffer slots that were (re)generated
+    std::vector<uint32_t> update(const ShaderProgram& terrainShader, uint32_t vertexId, uint32_t heightMapId,
+        uint32_t splatMapId, glm::ivec2 center);
 
-    void update(const ShaderProgram& terrainShader, uint32_t vertexId, glm::ivec2 center);
+    ChunkBounds getChunkBounds(uint32_t slot) const;
+    // chunk coordinates of the chunk in a buffer slot
+    glm::ivec2 getSlotChunk(uint32_t slot) const { return slotChunks[slot]; }
+    // buffer slot of a resident chunk, -1 if it is not resident
+    int32_t findSlot(glm::ivec2 chunk) const;
 
     void setConfig(const GenConfig& config) { this->config = config; }
+    // the config chunks are generated with, the gui edits a copy until it is applied
+    const GenConfig& getConfig() const { return config; }
+
+    // all chunks are regenerated with the new layout on the next update
+    void setVertexLayout(VertexLayout layout) {
+        vertexLayout = layout;
+        clearChunkCache();
+    }
 
     void clearChunkCache() { allocatedChunks.clear(); }
 
 private:
     std::unordered_set<glm::ivec2> getChunksInRange(glm::ivec2 center) const;
-    void genChunk(const ShaderProgram& terrainShader, uint32_t vertexId, glm::ivec2 chunkIdx, uint32_t buffIdx) const;
+    void genChunk(const ShaderProgram& terrainShader, uint32_t vertexId, uint32_t heightMapId, uint32_t splatMapId,
+        glm::ivec2 chunkIdx, uint32_t buffIdx) const;
+
+    // uniform indices in terrain.comp
+    struct {
+        int32_t gridSize = -1;
+        int32_t octaves = -1;
+        int32_t lacunarity = -1;
+        int32_t gain = -1;
+        int32_t chunkIdx = -1;
+        int32_t centerIdx = -1;
+        int32_t buffIdx = -1;
+        int32_t vertexLayout = -1;
+    } uniforms;
 
     GenConfig config;
+    VertexLayout vertexLayout = VertexLayout::RowMajor;
     glm::ivec2 currentCenter;
     std::unordered_map<glm::ivec2, uint32_t> allocatedChunks;
+    std::vector<glm::vec2> slotOrigins = std::vector<glm::vec2>(getChunkCount());
+    std::vector<glm::ivec2> slotChunks = std::vector<glm::ivec2>(getChunkCount());
 };
@@ -0,0 +1,353 @@
+#include "texture_loader.h"
+#include "dds.h"
+#include "mip_chain.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stb_image.h>
+#include <stdexcept>
+#include <string_view>
+
+constexpr size_t initialStagingSize = 32 * 1024 * 1024;
+
+// neutral grey, so lighting still reads while the real texture loads
+constexpr std::array<uint8_t, 4> placeholderColor{128, 128, 128, 255};
+
+static bool hasExtension(std::string_view extension) {
+    int32_t extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (int32_t i = 0; i < extensionCount; i++) {
+        if (reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)) == extension) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t createPlaceholder(GLenum target) {
+    uint32_t texture;
+    glCreateTextures(target, 1, &texture);
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        glTextureStorage3D(texture, 1, GL_RGBA8, 1, 1, 1);
+    } else {
+        glTextureStorage2D(texture, 1, GL_RGBA8, 1, 1);
+    }
+    glClearTexImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholderColor.data());
+    return texture;
+}
+
+TextureLoader::TextureLoader(uint32_t threadCount)
+    : placeholder2D(createPlaceholder(GL_TEXTURE_2D)), placeholderCube(createPlaceholder(GL_TEXTURE_CUBE_MAP)),
+      placeholderArray(createPlaceholder(GL_TEXTURE_2D_ARRAY)) {
+    createStagingBuffer(initialStagingSize);
+    s3tcSupported = hasExtension("GL_EXT_texture_compression_s3tc");
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(&TextureLoader::work, this);
+    }
+}
+
+TextureLoader::~TextureLoader() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    jobAdded.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (const Texture& texture : textures) {
+        if (texture.id != 0) {
+            glDeleteTextures(1, &texture.id);
+        }
+    }
+    glDeleteTextures(1, &placeholder2D);
+    glDeleteTextures(1, &placeholderCube);
+    glDeleteTextures(1, &placeholderArray);
+
+    if (uploadFence) {
+        glDeleteSync(uploadFence);
+    }
+    glUnmapNamedBuffer(stagingBuffer);
+    glDeleteBuffers(1, &stagingBuffer);
+}
+
+void TextureLoader::createStagingBuffer(size_t size) {
+    if (stagingBuffer != 0) {
+        glUnmapNamedBuffer(stagingBuffer);
+        glDeleteBuffers(1, &stagingBuffer);
+    }
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &stagingBuffer);
+    glNamedBufferStorage(stagingBuffer, size, nullptr, flags);
+    staging = static_cast<uint8_t*>(glMapNamedBufferRange(stagingBuffer, 0, size, flags));
+    if (!staging) {
+        throw std::runtime_error("failed to map texture staging buffer");
+    }
+    stagingSize = size;
+}
+
+// a converted .dds next to the image is loaded instead of it
+static std::string compressedOrOriginal(const std::string& path) {
+    std::filesystem::path dds(path);
+    dds.replace_extension(".dds");
+    return std::filesystem::exists(dds) ? dds.string() : path;
+}
+
+uint32_t TextureLoader::load2D(const std::string& path, bool flip) {
+    const uint32_t handle = textures.size();
+    textures.push_back({GL_TEXTURE_2D, 1});
+    {
+        std::lock_guard lock(mutex);
+        jobs.push_back({handle, 0, compressedOrOriginal(path), path, flip, true});
+    }
+    pendingCount++;
+    jobAdded.notify_one();
+    return handle;
+}
+
+uint32_t TextureLoader::loadCube(const std::array<std::string, 6>& faces) {
+    const uint32_t handle = textures.size();
+    textures.push_back({GL_TEXTURE_CUBE_MAP, 6});
+    {
+        std::lock_guard lock(mutex);
+        for (uint32_t face = 0; face < faces.size(); face++) {
+            jobs.push_back({handle, face, compressedOrOriginal(faces[face]), faces[face], false, false});
+        }
+    }
+    pendingCount += faces.size();
+    jobAdded.notify_all();
+    return handle;
+}
+
+uint32_t TextureLoader::loadArray(const std::vector<std::string>& layers, bool flip) {
+    const uint32_t handle = textures.size();
+    textures.push_back({GL_TEXTURE_2D_ARRAY, static_cast<uint32_t>(layers.size())});
+    {
+        std::lock_guard lock(mutex);
+        for (uint32_t layer = 0; layer < layers.size(); layer++) {
+            jobs.push_back({handle, layer, compressedOrOriginal(layers[layer]), layers[layer], flip, true});
+        }
+    }
+    pendingCount += layers.size();
+    jobAdded.notify_all();
+    return handle;
+}
+
+uint32_t TextureLoader::get(uint32_t handle) const {
+    const Texture& texture = textures[handle];
+    if (texture.id != 0 && texture.uploadedLayers == texture.layers) {
+        return texture.id;
+    }
+
+    // clang-format off
+    switch (texture.target) {
+    case GL_TEXTURE_CUBE_MAP: return placeholderCube;
+    case GL_TEXTURE_2D_ARRAY: return placeholderArray;
+    default: return placeholder2D;
+    }
+    // clang-format on
+}
+
+void TextureLoader::work() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock(mutex);
+            jobAdded.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Image image = decode(job);
+        std::lock_guard lock(mutex);
+        decoded.push_back(std::move(image));
+    }
+}
+
+TextureLoader::Image TextureLoader::decode(const Job& job) const {
+    Image image{job.handle, job.layer, job.path, GL_RGBA8, 0, 0, 0, {}};
+
+    // pre compressed images already have their mips and orientation baked in, loading them is a plain read
+    if (job.path.size() > 4 && job.path.compare(job.path.size() - 4, 4, ".dds") == 0) {
+        try {
+            DdsImage dds = loadDds(job.path);
+            if (dds.format != glCompressedRgbS3tcDxt1 || s3tcSupported) {
+                image.format = dds.format;
+                image.width = dds.width;
+                image.height = dds.height;
+                image.levels = job.mips ? dds.levels : 1;
+                image.pixels = std::move(dds.data);
+                image.pixels.resize(levelOffset(image, image.levels));
+                return image;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            image.pixels.clear();
+            return image;
+        }
+
+        // the driver can not sample bc1, the image it was converted from is decoded instead
+        image.path = job.source;
+    }
+
+    int32_t width, height, channels;
+    stbi_set_flip_vertically_on_load_thread(job.flip);
+    uint8_t* data = stbi_load(image.path.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        return image;
+    }
+
+    image.width = width;
+    image.height = height;
+    image.levels = job.mips ? mipLevelCount(width, height) : 1;
+    image.pixels = buildMipChain(data, width, height, image.levels);
+    stbi_image_free(data);
+    return image;
+}
+
+size_t TextureLoader::levelOffset(const Image& image, uint32_t level) {
+    if (image.format == GL_RGBA8) {
+        return mipLevelOffset(image.width, image.height, level);
+    }
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < level; i++) {
+        offset += ddsLevelSize(image.format, std::max(image.width >> i, 1), std::max(image.height >> i, 1));
+    }
+    return offset;
+}
+
+void TextureLoader::update() {
+    if (uploadFence) {
+        if (glClientWaitSync(uploadFence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        glDeleteSync(uploadFence);
+        uploadFence = nullptr;
+    }
+
+    std::vector<Image> images;
+    size_t used = 0;
+    {
+        std::lock_guard lock(mutex);
+        while (!decoded.empty()) {
+            const size_t size = decoded.front().pixels.size();
+            if (used + size > stagingSize && used > 0) {
+                break;
+            }
+            if (size > stagingSize) {
+                // nothing is in flight, so the buffer can be replaced
+                createStagingBuffer(size);
+            }
+            images.push_back(std::move(decoded.front()));
+            decoded.pop_front();
+            used += size;
+        }
+    }
+    if (images.empty()) {
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBuffer);
+    size_t offset = 0;
+    for (const Image& image : images) {
+        pendingCount--;
+        if (image.pixels.empty()) {
+            std::cerr << "ERROR: failed to load image " << image.path << std::endl;
+            failLayer(textures[image.handle]);
+            continue;
+        }
+
+        std::memcpy(staging + offset, image.pixels.data(), image.pixels.size());
+        upload(image, offset);
+        offset += image.pixels.size();
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// a missing layer of an array is left grey, any other texture keeps its placeholder
+void TextureLoader::failLayer(Texture& texture) {
+    if (texture.target == GL_TEXTURE_2D_ARRAY) {
+        texture.uploadedLayers++;
+    } else {
+        texture.failed = true;
+    }
+}
+
+void TextureLoader::upload(const Image& image, size_t offset) {
+    Texture& texture = textures[image.handle];
+    if (texture.failed) {
+        return;
+    }
+
+    if (texture.id == 0) {
+        texture.format = image.format;
+        texture.width = image.width;
+        texture.height = image.height;
+        texture.levels = image.levels;
+
+        glCreateTextures(texture.target, 1, &texture.id);
+        if (texture.target == GL_TEXTURE_2D_ARRAY) {
+            glTextureStorage3D(texture.id, image.levels, image.format, image.width, image.height, texture.layers);
+            // block compressed textures can not be cleared, their failed layers stay undefined
+            if (image.format == GL_RGBA8) {
+                for (uint32_t level = 0; level < image.levels; level++) {
+                    glClearTexImage(texture.id, level, GL_RGBA, GL_UNSIGNED_BYTE, placeholderColor.data());
+                }
+            }
+        } else {
+            glTextureStorage2D(texture.id, image.levels, image.format, image.width, image.height);
+        }
+
+        if (texture.target == GL_TEXTURE_CUBE_MAP) {
+            glTextureParameteri(texture.id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture.id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture.id, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(texture.id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        } else {
+            glTextureParameteri(texture.id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTextureParameteri(texture.id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTextureParameteri(texture.id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        }
+        glTextureParameteri(texture.id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    } else if (image.format != texture.format || image.width != texture.width || image.height != texture.height ||
+               image.levels != texture.levels) {
+        std::cerr << "ERROR: " << image.path << " does not match the size or format of the other layers" << std::endl;
+        failLayer(texture);
+        return;
+    }
+
+    // cube faces and array layers are both addressed as the z offset
+    const bool layered = texture.target != GL_TEXTURE_2D;
+    for (uint32_t level = 0; level < image.levels; level++) {
+        const int32_t width = std::max(image.width >> level, 1);
+        const int32_t height = std::max(image.height >> level, 1);
+        const auto* pixels = reinterpret_cast<const void*>(offset + levelOffset(image, level));
+        if (image.format != GL_RGBA8) {
+            const int32_t size = levelOffset(image, level + 1) - levelOffset(image, level);
+            if (layered) {
+                glCompressedTextureSubImage3D(
+                    texture.id, level, 0, 0, image.layer, width, height, 1, image.format, size, pixels);
+            } else {
+                glCompressedTextureSubImage2D(texture.id, level, 0, 0, width, height, image.format, size, pixels);
+            }
+        } else if (layered) {
+            glTextureSubImage3D(
+                texture.id, level, 0, 0, image.layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        } else {
+            glTextureSubImage2D(texture.id, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        }
+    }
+    texture.uploadedLayers++;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <glad/gl.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decodes images on worker threads and uploads them through a persistently mapped pixel buffer. Loading returns a
+// handle right away, get() gives a placeholder texture until every image of it is uploaded, so rendering can start
+// while textures are still streaming in. Mip chains are built on the workers as well. If a .dds file made by
+// texture_convert sits next to an image, its block compressed data and mips are loaded instead. BC1 needs
+// GL_EXT_texture_compression_s3tc, without it the image itself is decoded.
+class TextureLoader {
+public:
+    // 0 threads picks one less than the hardware threads
+    TextureLoader(uint32_t threadCount = 0);
+
+    TextureLoader(const TextureLoader& other) = delete;
+    TextureLoader& operator=(const TextureLoader& other) = delete;
+
+    ~TextureLoader();
+
+    // repeating, trilinear filtered texture with a full mip chain
+    uint32_t load2D(const std::string& path, bool flip);
+    // faces in +x, -x, +y, -y, +z, -z order
+    uint32_t loadCube(const std::array<std::string, 6>& faces);
+    // 2d array with a layer per image, like load2D otherwise. the images need the same size and format, layers that
+    // fail to load stay grey
+    uint32_t loadArray(const std::vector<std::string>& layers, bool flip);
+
+    // uploads what the workers finished, call once per frame. returns without uploading while the previous upload
+    // is still being read from the pixel buffer
+    void update();
+
+    uint32_t get(uint32_t handle) const;
+    // images that are decoding or waiting for upload
+    uint32_t getPendingCount() const { return pendingCount; }
+
+private:
+    struct Job {
+        uint32_t handle;
+        uint32_t layer;
+        std::string path;
+        std::string source; // the image a .dds path was converted from
+        bool flip;
+        bool mips;
+    };
+
+    struct Image {
+        uint32_t handle;
+        uint32_t layer;
+        std::string path;
+        GLenum format = GL_RGBA8; // or a block compressed format from a dds file
+        int32_t width = 0;
+        int32_t height = 0;
+        uint32_t levels = 0;
+        std::vector<uint8_t> pixels; // every level after the previous one. empty if decoding failed
+    };
+
+    struct Texture {
+        GLenum target;
+        uint32_t layers;
+        uint32_t id = 0; // created when the first image is uploaded, with its size and format
+        GLenum format = GL_RGBA8;
+        int32_t width = 0;
+        int32_t height = 0;
+        uint32_t levels = 0;
+        uint32_t uploadedLayers = 0;
+        bool failed = false;
+    };
+
+    void work();
+    Image decode(const Job& job) const;
+    static size_t levelOffset(const Image& image, uint32_t level);
+    void upload(const Image& image, size_t offset);
+    static void failLayer(Texture& texture);
+    void createStagingBuffer(size_t size);
+
+    std::vector<Texture> textures;
+    uint32_t placeholder2D;
+    uint32_t placeholderCube;
+    uint32_t placeholderArray;
+    uint32_t pendingCount = 0;
+    bool s3tcSupported = false; // set before the workers start, read only after
+
+    size_t stagingSize = 0;
+    uint8_t* staging = nullptr;
+    uint32_t stagingBuffer = 0;
+    GLsync uploadFence = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable jobAdded;
+    std::deque<Job> jobs;
+    std::deque<Image> decoded;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
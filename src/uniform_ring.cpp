@@ -0,0 +1,44 @@
+#include "uniform_ring.h"
+#include <cstring>
+#include <stdexcept>
+
+UniformRing::UniformRing(const FrameSync& frameSync, size_t frameSize) : frameSync(frameSync), frameSize(frameSize) {
+    int32_t offsetAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+    alignment = offsetAlignment;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const uint32_t frameCount = frameSync.getFrameCount();
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, frameSize * frameCount, nullptr, flags);
+    mapped = static_cast<uint8_t*>(glMapNamedBufferRange(buffer, 0, frameSize * frameCount, flags));
+    if (!mapped) {
+        throw std::runtime_error("failed to map uniform ring");
+    }
+}
+
+UniformRing::~UniformRing() {
+    glUnmapNamedBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+}
+
+void UniformRing::beginFrame() {
+    frame = frameSync.getFrameIndex();
+    used = 0;
+}
+
+size_t UniformRing::push(const void* data, size_t size) {
+    const size_t start = (used + alignment - 1) / alignment * alignment;
+    if (start + size > frameSize) {
+        throw std::runtime_error("uniform ring frame is full");
+    }
+
+    const size_t offset = frame * frameSize + start;
+    std::memcpy(mapped + offset, data, size);
+    used = start + size;
+    return offset;
+}
+
+void UniformRing::bind(uint32_t binding, size_t offset, size_t size) const {
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "frame_sync.h"
+#include <cstddef>
+#include <cstdint>
+#include <glad/gl.h>
+
+// Persistently mapped uniform buffer split into one region per frame of the frame sync. Data for a frame is written
+// straight into the mapping and bound by range. The frame sync makes sure the gpu is done reading a region before the
+// cpu writes to it again.
+class UniformRing {
+public:
+    UniformRing(const FrameSync& frameSync, size_t frameSize);
+
+    UniformRing(const UniformRing& other) = delete;
+    UniformRing& operator=(const UniformRing& other) = delete;
+
+    ~UniformRing();
+
+    // moves on to the region of the current frame, call after FrameSync::beginFrame
+    void beginFrame();
+
+    // copies data into the region of this frame and returns its offset in the buffer
+    size_t push(const void* data, size_t size);
+    template <typename T>
+    size_t push(const T& data) {
+        return push(&data, sizeof(T));
+    }
+
+    void bind(uint32_t binding, size_t offset, size_t size) const;
+
+private:
+    const FrameSync& frameSync;
+    size_t frameSize;
+    uint32_t frame = 0;
+    size_t used = 0;
+    size_t alignment;
+
+    uint8_t* mapped;
+    uint32_t buffer;
+};
@@ -0,0 +1,255 @@
+#include "virtual_texture.h"
+#include <algorithm>
+#include <array>
+#include <glad/gl.h>
+#include <numeric>
+
+VirtualTexture::VirtualTexture(uint32_t slotCount)
+    : slotCount(slotCount), pages(cachePagesPerSide * cachePagesPerSide), dirtySlots(slotCount, true),
+      missingTop(slotCount, true) {
+    // integer entries, xy cache page, z level of the page it points to, w 1 if it points anywhere
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &pageTable);
+    glTextureStorage3D(pageTable, levelCount, GL_RGBA8UI, pagesPerSide, pagesPerSide, slotCount);
+    glTextureParameteri(pageTable, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(pageTable, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    constexpr uint32_t cacheSize = cachePagesPerSide * paddedPageSize;
+    glCreateTextures(GL_TEXTURE_2D, 1, &cache);
+    glTextureStorage2D(cache, 1, GL_RGBA8, cacheSize, cacheSize);
+    glTextureParameteri(cache, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(cache, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(cache, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(cache, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+VirtualTexture::~VirtualTexture() {
+    glDeleteTextures(1, &pageTable);
+    glDeleteTextures(1, &cache);
+    if (feedback != 0) {
+        glDeleteTextures(1, &feedback);
+        glDeleteBuffers(1, &readbackBuffer);
+    }
+    if (readbackFence) {
+        glDeleteSync(readbackFence);
+    }
+}
+
+void VirtualTexture::invalidate(const std::vector<uint32_t>& slots) {
+    for (const uint32_t slot : slots) {
+        dirtySlots[slot] = true;
+        missingTop[slot] = true;
+    }
+    for (uint32_t i = 0; i < pages.size(); i++) {
+        if (pages[i].key != noPage && std::find(slots.begin(), slots.end(), pages[i].key >> 16) != slots.end()) {
+            evict(i);
+        }
+    }
+}
+
+void VirtualTexture::update(
+    const ShaderProgram& bakeShader, const TerrainGen& terrainGen, uint32_t splatMapId, uint32_t materialsId) {
+    frame++;
+    if (materialsId != bakedMaterials) {
+        std::vector<uint32_t> all(slotCount);
+        std::iota(all.begin(), all.end(), 0);
+        invalidate(all);
+        bakedMaterials = materialsId;
+    }
+
+    // the fallback for everything else comes first and can not be skipped. it stays missing until it is baked
+    std::vector<uint32_t> missing;
+    for (uint32_t slot = 0; slot < slotCount; slot++) {
+        if (missingTop[slot]) {
+            missing.push_back(pageKey(slot, levelCount - 1, 0, 0));
+        }
+    }
+    const size_t topCount = missing.size();
+    readFeedback(missing);
+
+    bakeShader.bind();
+    glBindTextureUnit(0, materialsId);
+    glBindTextureUnit(7, splatMapId);
+    glBindImageTexture(0, cache, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+    bakedCount = 0;
+    for (size_t i = 0; i < missing.size() && i < topCount + maxBakesPerFrame; i++) {
+        // the feedback can ask for a top page that is already queued
+        if (resident.count(missing[i]) != 0) {
+            continue;
+        }
+        const uint32_t physical = allocate();
+        if (physical == noPage) {
+            break;
+        }
+        bake(bakeShader, terrainGen, missing[i], physical);
+        pages[physical] = {missing[i], frame};
+        resident[missing[i]] = physical;
+        const uint32_t slot = missing[i] >> 16;
+        dirtySlots[slot] = true;
+        if (((missing[i] >> 12) & 0xf) == levelCount - 1) {
+            missingTop[slot] = false;
+        }
+        bakedCount++;
+    }
+    if (bakedCount > 0) {
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    for (uint32_t slot = 0; slot < slotCount; slot++) {
+        if (dirtySlots[slot]) {
+            writePageTable(slot);
+            dirtySlots[slot] = false;
+        }
+    }
+}
+
+void VirtualTexture::readFeedback(std::vector<uint32_t>& missing) {
+    if (!readbackFence || glClientWaitSync(readbackFence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        return;
+    }
+    glDeleteSync(readbackFence);
+    readbackFence = nullptr;
+
+    const size_t count = static_cast<size_t>(feedbackSize.x) * feedbackSize.y;
+    const auto* texels = static_cast<const uint32_t*>(
+        glMapNamedBufferRange(readbackBuffer, 0, count * sizeof(uint32_t), GL_MAP_READ_BIT));
+    std::unordered_map<uint32_t, uint32_t> requests;
+    for (size_t i = 0; i < count; i++) {
+        if (texels[i] != noPage) {
+            requests[texels[i]]++;
+        }
+    }
+    glUnmapNamedBuffer(readbackBuffer);
+
+    const size_t first = missing.size();
+    for (const auto& [key, _] : requests) {
+        const uint32_t slot = key >> 16;
+        const uint32_t level = (key >> 12) & 0xf;
+        const uint32_t side = level < levelCount ? pagesPerSide >> level : 0;
+        if (slot >= slotCount || (key & 0x3f) >= side || ((key >> 6) & 0x3f) >= side) {
+            continue;
+        }
+
+        const auto it = resident.find(key);
+        if (it != resident.end()) {
+            pages[it->second].lastUsed = frame;
+        } else {
+            missing.push_back(key);
+        }
+    }
+
+    // coarse pages cover more pixels and become the fallback of the finer ones, then the most requested
+    std::sort(missing.begin() + first, missing.end(), [&requests](uint32_t a, uint32_t b) {
+        const uint32_t levelA = (a >> 12) & 0xf;
+        const uint32_t levelB = (b >> 12) & 0xf;
+        return levelA != levelB ? levelA > levelB : requests[a] > requests[b];
+    });
+}
+
+uint32_t VirtualTexture::allocate() {
+    uint32_t oldest = noPage;
+    for (uint32_t i = 0; i < pages.size(); i++) {
+        const PhysicalPage& page = pages[i];
+        if (page.key == noPage) {
+            return i;
+        }
+        const bool top = ((page.key >> 12) & 0xf) == levelCount - 1;
+        if (!top && page.lastUsed < frame && (oldest == noPage || page.lastUsed < pages[oldest].lastUsed)) {
+            oldest = i;
+        }
+    }
+
+    if (oldest != noPage) {
+        evict(oldest);
+    }
+    return oldest;
+}
+
+void VirtualTexture::evict(uint32_t physical) {
+    const uint32_t key = pages[physical].key;
+    resident.erase(key);
+    dirtySlots[key >> 16] = true;
+    pages[physical].key = noPage;
+}
+
+void VirtualTexture::bake(
+    const ShaderProgram& bakeShader, const TerrainGen& terrainGen, uint32_t key, uint32_t physical) const {
+    const uint32_t slot = key >> 16;
+    const glm::ivec2 cachePage(physical % cachePagesPerSide, physical / cachePagesPerSide);
+    bakeShader.set("slot", slot);
+    bakeShader.set("level", static_cast<int32_t>((key >> 12) & 0xf));
+    bakeShader.set("page", glm::ivec2(key & 0x3f, (key >> 6) & 0x3f));
+    bakeShader.set("cacheOrigin", cachePage * static_cast<int32_t>(paddedPageSize));
+    bakeShader.set("chunkOrigin", terrainGen.getChunkBounds(slot).min);
+    bakeShader.set("chunkExtent", (TerrainGen::chunkSize - 1) * TerrainGen::sampleSpacing);
+    glDispatchCompute((paddedPageSize + 7) / 8, (paddedPageSize + 7) / 8, 1);
+}
+
+void VirtualTexture::writePageTable(uint32_t slot) const {
+    // coarsest level first, pages that are not resident take the entry of their parent
+    std::vector<std::array<uint8_t, 4>> parent;
+    std::vector<std::array<uint8_t, 4>> entries;
+    for (int32_t level = levelCount - 1; level >= 0; level--) {
+        const uint32_t side = pagesPerSide >> level;
+        entries.assign(side * side, {0, 0, 0, 0});
+        for (uint32_t y = 0; y < side; y++) {
+            for (uint32_t x = 0; x < side; x++) {
+                const auto it = resident.find(pageKey(slot, level, x, y));
+                if (it != resident.end()) {
+                    const uint32_t physical = it->second;
+                    entries[y * side + x] = {static_cast<uint8_t>(physical % cachePagesPerSide),
+                        static_cast<uint8_t>(physical / cachePagesPerSide), static_cast<uint8_t>(level), 1};
+                } else if (!parent.empty()) {
+                    entries[y * side + x] = parent[(y / 2) * (side / 2) + x / 2];
+                }
+            }
+        }
+        glTextureSubImage3D(
+            pageTable, level, 0, 0, slot, side, side, 1, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entries.data());
+        std::swap(parent, entries);
+    }
+}
+
+void VirtualTexture::bind(const ShaderProgram& shader, glm::ivec2 viewportSize) {
+    constexpr int32_t scale = feedbackScale;
+    const glm::ivec2 size = (viewportSize + scale - 1) / scale;
+    if (size != feedbackSize) {
+        if (feedback != 0) {
+            glDeleteTextures(1, &feedback);
+            glDeleteBuffers(1, &readbackBuffer);
+        }
+        // a readback of the old size is useless now
+        if (readbackFence) {
+            glDeleteSync(readbackFence);
+            readbackFence = nullptr;
+        }
+
+        feedbackSize = size;
+        glCreateTextures(GL_TEXTURE_2D, 1, &feedback);
+        glTextureStorage2D(feedback, 1, GL_R32UI, size.x, size.y);
+        glCreateBuffers(1, &readbackBuffer);
+        glNamedBufferStorage(readbackBuffer, size.x * size.y * sizeof(uint32_t), nullptr, GL_MAP_READ_BIT);
+    }
+
+    // a different pixel of every block writes each frame, after feedbackScale^2 frames all of them did
+    const uint32_t pixel = frame % (feedbackScale * feedbackScale);
+    shader.set("feedbackOffset", glm::ivec2(pixel % feedbackScale, pixel / feedbackScale));
+
+    glClearTexImage(feedback, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &noPage);
+    glBindImageTexture(0, feedback, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+    glBindTextureUnit(8, pageTable);
+    glBindTextureUnit(9, cache);
+}
+
+void VirtualTexture::endFrame() {
+    if (readbackFence || feedback == 0) {
+        return;
+    }
+
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffer);
+    glGetTextureImage(feedback, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, feedbackSize.x * feedbackSize.y * sizeof(uint32_t),
+        nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
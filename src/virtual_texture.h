@@ -0,0 +1,87 @@
+#pragma once
+#include "shader_program.h"
+#include "terrain_gen.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+// Virtual texture of the blended terrain materials. Every chunk slot has a mip chain of pages, which are baked by
+// compute into a cache of physical pages when the shading pass asks for them. A page table per slot maps every page to
+// itself or to its closest resident ancestor, so shading is a single indirection and fetch for any number of materials.
+// The shading pass writes the pages it wants into a low resolution feedback image, which is read back asynchronously
+// and drives baking and eviction. The top page of every slot is always resident.
+class VirtualTexture {
+public:
+    // sync with virtual_page.comp and shader.frag
+    static constexpr uint32_t pageSize = 128;
+    static constexpr uint32_t pageBorder = 4; // repeats the neighbouring texels, for bilinear filtering in the cache
+    static constexpr uint32_t paddedPageSize = pageSize + 2 * pageBorder;
+    static constexpr uint32_t pagesPerSide = 16; // of a slot at level 0, 2 texels per world unit
+    static constexpr uint32_t levelCount = 5;    // down to a single page per slot
+    static constexpr uint32_t feedbackScale = 8; // one feedback texel per feedbackScale^2 pixels
+
+    static constexpr uint32_t cachePagesPerSide = 30;
+    static constexpr uint32_t maxBakesPerFrame = 16;
+    static_assert((pagesPerSide >> (levelCount - 1)) == 1, "the top level must be a single page");
+    static_assert(cachePagesPerSide <= 255, "cache page coordinates are stored in 8 bits");
+
+    VirtualTexture(uint32_t slotCount);
+
+    VirtualTexture(const VirtualTexture& other) = delete;
+    VirtualTexture& operator=(const VirtualTexture& other) = delete;
+
+    ~VirtualTexture();
+
+    // drops the pages of regenerated slots
+    void invalidate(const std::vector<uint32_t>& slots);
+
+    // reads back the feedback of an earlier frame if it is ready and bakes the pages it asks for, coarse pages first.
+    // every page is dropped when the material texture changes, since it is a placeholder until it is loaded
+    void update(const ShaderProgram& bakeShader, const TerrainGen& terrainGen, uint32_t splatMapId,
+        uint32_t materialsId);
+
+    // before the shading pass, clears the feedback and binds everything the shader reads and writes
+    void bind(const ShaderProgram& shader, glm::ivec2 viewportSize);
+    // after the shading pass, starts reading the feedback back unless an earlier readback is still in flight
+    void endFrame();
+
+    uint32_t getResidentCount() const { return static_cast<uint32_t>(resident.size()); }
+    uint32_t getBakedCount() const { return bakedCount; }
+
+private:
+    static constexpr uint32_t noPage = ~0u; // feedback clear value and key of a free physical page
+
+    // same packing as the feedback written by shader.frag
+    static uint32_t pageKey(uint32_t slot, uint32_t level, uint32_t x, uint32_t y) {
+        return x | (y << 6) | (level << 12) | (slot << 16);
+    }
+
+    struct PhysicalPage {
+        uint32_t key = noPage;
+        uint64_t lastUsed = 0;
+    };
+
+    void readFeedback(std::vector<uint32_t>& missing);
+    // a free page or the least recently used one that was not needed this frame, noPage if there is none
+    uint32_t allocate();
+    void bake(const ShaderProgram& bakeShader, const TerrainGen& terrainGen, uint32_t key, uint32_t physical) const;
+    void evict(uint32_t physical);
+    void writePageTable(uint32_t slot) const;
+
+    uint32_t slotCount;
+    uint32_t pageTable;
+    uint32_t cache;
+    std::vector<PhysicalPage> pages;
+    std::unordered_map<uint32_t, uint32_t> resident; // key to physical page
+    std::vector<bool> dirtySlots;
+    std::vector<bool> missingTop;
+    uint32_t bakedMaterials = 0;
+    uint64_t frame = 0;
+    uint32_t bakedCount = 0;
+
+    uint32_t feedback = 0;
+    glm::ivec2 feedbackSize{0, 0};
+    uint32_t readbackBuffer = 0;
+    GLsync readbackFence = nullptr;
+};
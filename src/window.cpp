@@ -10,6 +10,31 @@ Window::Window(uint32_t width, uint32_t height, const char* title)
 
     glfwSetWindowUserPointer(glfwWindow.get(), this);
     glfwMakeContextCurrent(glfwWindow.get());
-    glfwSwapInterval(1);
+    setPresentMode(PresentMode::Vsync);
     glfwSetKeyCallback(glfwWindow.get(), &Window::keyCallback);
+    glfwSetCharCallback(glfwWindow.get(), [](GLFWwindow* window, unsigned int) { eventCallback(window); });
+    glfwSetCursorPosCallback(glfwWindow.get(), [](GLFWwindow* window, double, double) { eventCallback(window); });
+    glfwSetMouseButtonCallback(glfwWindow.get(), [](GLFWwindow* window, int, int, int) { eventCallback(window); });
+    glfwSetScrollCallback(glfwWindow.get(), [](GLFWwindow* window, double, double) { eventCallback(window); });
+    glfwSetWindowRefreshCallback(glfwWindow.get(), &Window::eventCallback);
+}
+
+bool Window::setPresentMode(PresentMode mode) {
+    // a negative interval needs the swap control tear extension
+    const bool supported = mode != PresentMode::AdaptiveVsync || glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+                           glfwExtensionSupported("GLX_EXT_swap_control_tear");
+    presentMode = supported ? mode : PresentMode::Vsync;
+
+    switch (presentMode) {
+    case PresentMode::Vsync:
+        glfwSwapInterval(1);
+        break;
+    case PresentMode::AdaptiveVsync:
+        glfwSwapInterval(-1);
+        break;
+    case PresentMode::Uncapped:
+        glfwSwapInterval(0);
+        break;
+    }
+    return supported;
 }
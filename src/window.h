@@ -4,6 +4,13 @@
 #include <cstdint>
 #include <glad/gl.h>
 #include <memory>
+#include <utility>
+
+enum class PresentMode {
+    Vsync,         // waits for the vertical blank
+    AdaptiveVsync, // waits unless the frame is already late, then tears instead of dropping to half rate
+    Uncapped,      // presents immediately
+};
 
 struct WindowSize {
     uint32_t w;
@@ -23,6 +30,13 @@ public:
 
     Input& getInput() { return input; }
 
+    // false if the mode is not supported, vsync is used instead
+    bool setPresentMode(PresentMode mode);
+    PresentMode getPresentMode() const { return presentMode; }
+
+    // whether any input or a redraw request from the system arrived since the last call
+    bool takeEvents() { return std::exchange(eventsReceived, false); }
+
 private:
     struct DeleteGlfwWindow {
         void operator()(GLFWwindow* w) { glfwDestroyWindow(w); }
@@ -32,10 +46,18 @@ private:
         (void)scancode;
         (void)mods;
 
-        const auto& win = *reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        auto& win = *reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
         win.input.keyCallback(key, action);
+        win.eventsReceived = true;
+    }
+
+    // the gui installs its callbacks after these and forwards to them
+    static void eventCallback(GLFWwindow* window) {
+        reinterpret_cast<Window*>(glfwGetWindowUserPointer(window))->eventsReceived = true;
     }
 
     std::unique_ptr<GLFWwindow, DeleteGlfwWindow> glfwWindow;
     Input input;
+    bool eventsReceived = true;
+    PresentMode presentMode = PresentMode::Vsync;
 };
@@ -0,0 +1,160 @@
+// Measures post transform vertex cache efficiency of the chunk index buffer, and how well the vertex fetches of each
+// vertex layout hit a small cache of memory lines.
+// ACMR: vertex shader invocations per triangle, 0.5 is the optimum for a regular grid
+// ATVR: vertex shader invocations per unique vertex, 1.0 is the optimum
+#include "terrain_gen.h"
+#include <cstdio>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+struct CacheStats {
+    double acmr;
+    double atvr;
+};
+
+static CacheStats toStats(size_t misses, size_t indexCount, size_t vertexCount) {
+    return CacheStats{
+        static_cast<double>(misses) / static_cast<double>(indexCount / 3),
+        static_cast<double>(misses) / static_cast<double>(vertexCount),
+    };
+}
+
+// classic fifo cache, a hit does not refresh the entry
+static CacheStats simulateFifo(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+    std::vector<uint32_t> cache(cacheSize, UINT32_MAX);
+    std::vector<bool> cached(vertexCount, false);
+    uint32_t head = 0;
+    size_t misses = 0;
+
+    for (const uint32_t idx : indices) {
+        if (cached[idx]) {
+            continue;
+        }
+
+        misses++;
+        if (cache[head] != UINT32_MAX) {
+            cached[cache[head]] = false;
+        }
+        cache[head] = idx;
+        cached[idx] = true;
+        head = (head + 1) % cacheSize;
+    }
+
+    return toStats(misses, indices.size(), vertexCount);
+}
+
+static CacheStats simulateLru(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+    std::list<uint32_t> cache;
+    std::unordered_map<uint32_t, std::list<uint32_t>::iterator> entries;
+    size_t misses = 0;
+
+    for (const uint32_t idx : indices) {
+        const auto it = entries.find(idx);
+        if (it != entries.end()) {
+            cache.splice(cache.begin(), cache, it->second);
+            continue;
+        }
+
+        misses++;
+        if (cache.size() == cacheSize) {
+            entries.erase(cache.back());
+            cache.pop_back();
+        }
+        cache.push_front(idx);
+        entries[idx] = cache.begin();
+    }
+
+    return toStats(misses, indices.size(), vertexCount);
+}
+
+// memory lines read per triangle by the vertex fetch. vertices missing the post transform fifo are fetched through an
+// lru cache of 64 byte lines
+static double simulateFetch(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t postTransformSize,
+    uint32_t lineCacheSize) {
+    constexpr size_t lineSize = 64;
+
+    std::vector<uint32_t> cache(postTransformSize, UINT32_MAX);
+    std::vector<bool> cached(vertexCount, false);
+    uint32_t head = 0;
+
+    std::list<size_t> lines;
+    std::unordered_map<size_t, std::list<size_t>::iterator> lineEntries;
+    size_t lineMisses = 0;
+
+    const auto fetch = [&](size_t line) {
+        const auto it = lineEntries.find(line);
+        if (it != lineEntries.end()) {
+            lines.splice(lines.begin(), lines, it->second);
+            return;
+        }
+
+        lineMisses++;
+        if (lines.size() == lineCacheSize) {
+            lineEntries.erase(lines.back());
+            lines.pop_back();
+        }
+        lines.push_front(line);
+        lineEntries[line] = lines.begin();
+    };
+
+    for (const uint32_t idx : indices) {
+        if (cached[idx]) {
+            continue;
+        }
+
+        if (cache[head] != UINT32_MAX) {
+            cached[cache[head]] = false;
+        }
+        cache[head] = idx;
+        cached[idx] = true;
+        head = (head + 1) % postTransformSize;
+
+        const size_t begin = idx * sizeof(Vertex);
+        const size_t end = begin + sizeof(Vertex) - 1;
+        fetch(begin / lineSize);
+        if (end / lineSize != begin / lineSize) {
+            fetch(end / lineSize);
+        }
+    }
+
+    return static_cast<double>(lineMisses) / static_cast<double>(indices.size() / 3);
+}
+
+int main() {
+    constexpr size_t vertexCount = TerrainGen::chunkSize * TerrainGen::chunkSize;
+    constexpr uint32_t cacheSizes[] = {16, 24, 32, 64};
+
+    const std::pair<const char*, IndexOrder> orders[] = {
+        {"row major", IndexOrder::RowMajor},
+        {"strips", IndexOrder::Strips},
+    };
+
+    const std::pair<const char*, VertexLayout> layouts[] = {
+        {"row major", VertexLayout::RowMajor},
+        {"morton", VertexLayout::Morton},
+    };
+
+    std::printf("%-12s %-6s %6s %8s %8s\n", "order", "cache", "size", "acmr", "atvr");
+    for (const auto& [name, order] : orders) {
+        const std::vector<uint32_t> indices = TerrainGen::genHeightIndices(order);
+        for (const uint32_t size : cacheSizes) {
+            const CacheStats fifo = simulateFifo(indices, vertexCount, size);
+            std::printf("%-12s %-6s %6u %8.3f %8.3f\n", name, "fifo", size, fifo.acmr, fifo.atvr);
+        }
+        for (const uint32_t size : cacheSizes) {
+            const CacheStats lru = simulateLru(indices, vertexCount, size);
+            std::printf("%-12s %-6s %6u %8.3f %8.3f\n", name, "lru", size, lru.acmr, lru.atvr);
+        }
+    }
+
+    // 256 lines is a 16kb cache
+    std::printf("\n%-12s %-12s %12s\n", "order", "layout", "lines/tri");
+    for (const auto& [orderName, order] : orders) {
+        for (const auto& [layoutName, layout] : layouts) {
+            const std::vector<uint32_t> indices = TerrainGen::genHeightIndices(order, layout);
+            const double lines = simulateFetch(indices, vertexCount, 32, 256);
+            std::printf("%-12s %-12s %12.3f\n", orderName, layoutName, lines);
+        }
+    }
+}
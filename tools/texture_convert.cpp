@@ -0,0 +1,265 @@
+// Converts an image into a block compressed .dds with a full mip chain, which the texture loader picks up instead of
+// the image when it sits next to it.
+// usage: texture_convert <image> <output.dds> <bc1|bc5|bc7> [--flip]
+// bc1: rgb, 4 bits per pixel. bc5: two channels (normal maps), 8 bits per pixel. bc7: rgba, 8 bits per pixel
+// --flip stores the rows bottom up, like stbi_set_flip_vertically_on_load, since dds files are not flipped on load
+#include "dds.h"
+#include "mip_chain.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stb_image.h>
+#include <string>
+
+using Block = std::array<std::array<int32_t, 4>, 16>; // rgba of the 4x4 pixels, row by row
+
+// writes values into a block little endian, lowest bit first
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* out) : out(out) {}
+
+    void write(uint32_t value, uint32_t bits) {
+        for (uint32_t i = 0; i < bits; i++, position++) {
+            out[position / 8] |= ((value >> i) & 1) << (position % 8);
+        }
+    }
+
+private:
+    uint8_t* out;
+    uint32_t position = 0;
+};
+
+static int32_t distance(const std::array<int32_t, 4>& a, const std::array<int32_t, 4>& b, uint32_t channels) {
+    int32_t sum = 0;
+    for (uint32_t c = 0; c < channels; c++) {
+        sum += (a[c] - b[c]) * (a[c] - b[c]);
+    }
+    return sum;
+}
+
+template <size_t N>
+static uint32_t closest(
+    const std::array<int32_t, 4>& pixel, const std::array<std::array<int32_t, 4>, N>& palette, uint32_t channels) {
+    uint32_t best = 0;
+    for (uint32_t i = 1; i < N; i++) {
+        if (distance(pixel, palette[i], channels) < distance(pixel, palette[best], channels)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// endpoints are the corners of the bounding box of the colors
+static void encodeBc1(const Block& block, uint8_t* out) {
+    std::array<int32_t, 4> lo{255, 255, 255, 255};
+    std::array<int32_t, 4> hi{0, 0, 0, 0};
+    for (const auto& pixel : block) {
+        for (uint32_t c = 0; c < 3; c++) {
+            lo[c] = std::min(lo[c], pixel[c]);
+            hi[c] = std::max(hi[c], pixel[c]);
+        }
+    }
+
+    const auto to565 = [](const std::array<int32_t, 4>& color) {
+        const int32_t r = (color[0] * 31 + 127) / 255;
+        const int32_t g = (color[1] * 63 + 127) / 255;
+        const int32_t b = (color[2] * 31 + 127) / 255;
+        return uint16_t(r << 11 | g << 5 | b);
+    };
+    const auto from565 = [](uint16_t color) {
+        return std::array<int32_t, 4>{
+            (color >> 11) * 255 / 31, ((color >> 5) & 63) * 255 / 63, (color & 31) * 255 / 31, 255};
+    };
+
+    uint16_t color0 = to565(hi);
+    uint16_t color1 = to565(lo);
+    // color0 > color1 selects the four color mode without transparency
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    std::array<std::array<int32_t, 4>, 4> palette{from565(color0), from565(color1)};
+    for (uint32_t c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    for (uint32_t i = 0; i < 16 && color0 != color1; i++) {
+        indices |= closest(block[i], palette, 3) << (i * 2);
+    }
+
+    std::memcpy(out, &color0, 2);
+    std::memcpy(out + 2, &color1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+// one channel in the eight value mode, the bc5 halves
+static void encodeBc4(const Block& block, uint32_t channel, uint8_t* out) {
+    int32_t lo = 255;
+    int32_t hi = 0;
+    for (const auto& pixel : block) {
+        lo = std::min(lo, pixel[channel]);
+        hi = std::max(hi, pixel[channel]);
+    }
+
+    std::array<std::array<int32_t, 4>, 8> palette{};
+    palette[0][0] = hi;
+    palette[1][0] = lo;
+    for (int32_t i = 1; i < 7; i++) {
+        palette[i + 1][0] = ((7 - i) * hi + i * lo) / 7;
+    }
+
+    BitWriter writer(out);
+    writer.write(hi, 8);
+    writer.write(lo, 8);
+    for (const auto& pixel : block) {
+        writer.write(hi == lo ? 0 : closest({pixel[channel]}, palette, 1), 3);
+    }
+}
+
+static void encodeBc5(const Block& block, uint8_t* out) {
+    encodeBc4(block, 0, out);
+    encodeBc4(block, 1, out + 8);
+}
+
+// mode 6 only: one subset, rgba endpoints of 7 bits plus a p bit each and 4 bit indices
+static void encodeBc7(const Block& block, uint8_t* out) {
+    std::array<int32_t, 4> lo{255, 255, 255, 255};
+    std::array<int32_t, 4> hi{0, 0, 0, 0};
+    for (const auto& pixel : block) {
+        for (uint32_t c = 0; c < 4; c++) {
+            lo[c] = std::min(lo[c], pixel[c]);
+            hi[c] = std::max(hi[c], pixel[c]);
+        }
+    }
+
+    // the p bit is shared by the channels of an endpoint, pick the one that is closer overall
+    struct Endpoint {
+        std::array<int32_t, 4> quantized;
+        int32_t p;
+        std::array<int32_t, 4> color;
+    };
+    const auto quantize = [](const std::array<int32_t, 4>& color) {
+        Endpoint best{};
+        int32_t bestError = INT32_MAX;
+        for (int32_t p = 0; p < 2; p++) {
+            Endpoint endpoint{{}, p, {}};
+            int32_t error = 0;
+            for (uint32_t c = 0; c < 4; c++) {
+                endpoint.quantized[c] = std::clamp((color[c] - p + 1) / 2, 0, 127);
+                endpoint.color[c] = endpoint.quantized[c] << 1 | p;
+                error += std::abs(endpoint.color[c] - color[c]);
+            }
+            if (error < bestError) {
+                best = endpoint;
+                bestError = error;
+            }
+        }
+        return best;
+    };
+
+    Endpoint endpoints[2] = {quantize(lo), quantize(hi)};
+    constexpr std::array<int32_t, 16> weights{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    std::array<std::array<int32_t, 4>, 16> palette;
+    for (uint32_t i = 0; i < 16; i++) {
+        for (uint32_t c = 0; c < 4; c++) {
+            palette[i][c] = ((64 - weights[i]) * endpoints[0].color[c] + weights[i] * endpoints[1].color[c] + 32) >> 6;
+        }
+    }
+
+    std::array<uint32_t, 16> indices;
+    for (uint32_t i = 0; i < 16; i++) {
+        indices[i] = closest(block[i], palette, 4);
+    }
+    // the top bit of the first index is implicitly 0, swapping the endpoints mirrors the indices
+    if (indices[0] >= 8) {
+        std::swap(endpoints[0], endpoints[1]);
+        for (uint32_t& index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    BitWriter writer(out);
+    writer.write(1 << 6, 7);
+    for (uint32_t c = 0; c < 4; c++) {
+        writer.write(endpoints[0].quantized[c], 7);
+        writer.write(endpoints[1].quantized[c], 7);
+    }
+    writer.write(endpoints[0].p, 1);
+    writer.write(endpoints[1].p, 1);
+    for (uint32_t i = 0; i < 16; i++) {
+        writer.write(indices[i], i == 0 ? 3 : 4);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::fprintf(stderr, "usage: %s <image> <output.dds> <bc1|bc5|bc7> [--flip]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string mode = argv[3];
+    const GLenum format = mode == "bc1"   ? glCompressedRgbS3tcDxt1
+                          : mode == "bc5" ? GL_COMPRESSED_RG_RGTC2
+                          : mode == "bc7" ? GL_COMPRESSED_RGBA_BPTC_UNORM
+                                          : 0;
+    if (format == 0) {
+        std::fprintf(stderr, "unknown format %s\n", argv[3]);
+        return 1;
+    }
+    const auto encode = format == glCompressedRgbS3tcDxt1 ? encodeBc1 : format == GL_COMPRESSED_RG_RGTC2 ? encodeBc5
+                                                                                                          : encodeBc7;
+
+    int32_t width, height, channels;
+    stbi_set_flip_vertically_on_load(argc > 4 && std::string(argv[4]) == "--flip");
+    uint8_t* pixels = stbi_load(argv[1], &width, &height, &channels, 4);
+    if (!pixels) {
+        std::fprintf(stderr, "failed to load %s: %s\n", argv[1], stbi_failure_reason());
+        return 1;
+    }
+
+    const uint32_t levels = mipLevelCount(width, height);
+    const std::vector<uint8_t> chain = buildMipChain(pixels, width, height, levels);
+    stbi_image_free(pixels);
+
+    DdsImage image{format, width, height, levels, {}};
+    for (uint32_t level = 0; level < levels; level++) {
+        const int32_t levelWidth = std::max(width >> level, 1);
+        const int32_t levelHeight = std::max(height >> level, 1);
+        const uint8_t* src = chain.data() + mipLevelOffset(width, height, level);
+
+        const size_t start = image.data.size();
+        image.data.resize(start + ddsLevelSize(format, levelWidth, levelHeight));
+        uint8_t* out = image.data.data() + start;
+
+        // edge pixels are repeated into blocks that stick out of the level
+        for (int32_t by = 0; by < levelHeight; by += 4) {
+            for (int32_t bx = 0; bx < levelWidth; bx += 4) {
+                Block block;
+                for (int32_t i = 0; i < 16; i++) {
+                    const int32_t x = std::min(bx + i % 4, levelWidth - 1);
+                    const int32_t y = std::min(by + i / 4, levelHeight - 1);
+                    for (int32_t c = 0; c < 4; c++) {
+                        block[i][c] = src[(size_t(y) * levelWidth + x) * 4 + c];
+                    }
+                }
+                encode(block, out);
+                out += ddsBlockSize(format);
+            }
+        }
+    }
+
+    try {
+        saveDds(argv[2], image);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::printf("%s: %dx%d, %u levels, %zu bytes\n", argv[2], width, height, levels, image.data.size());
+    return 0;
+}